@@ -61,6 +61,7 @@ struct disk {
 
     long long read_cnt;  /* Number of sectors read. */
     long long write_cnt; /* Number of sectors written. */
+    long long cmd_cnt;   /* Number of read and write commands. */
 };
 
 /* An ATA channel (aka controller).
@@ -86,7 +87,7 @@ static void reset_channel(struct channel *);
 static bool check_device_type(struct disk *);
 static void identify_ata_device(struct disk *);
 
-static void select_sector(struct disk *, disk_sector_t);
+static void select_sector(struct disk *, disk_sector_t, size_t sec_cnt);
 static void issue_pio_command(struct channel *, uint8_t command);
 static void input_sector(struct channel *, void *);
 static void output_sector(struct channel *, const void *);
@@ -120,7 +121,7 @@ void disk_init(void) {
             default:
                 NOT_REACHED();
         }
-        lock_init(&c->lock);
+        lock_init_named(&c->lock, c->name);
         c->expecting_interrupt = false;
         sema_init(&c->completion_wait, 0);
 
@@ -167,7 +168,8 @@ void disk_print_stats(void) {
         for (dev_no = 0; dev_no < 2; dev_no++) {
             struct disk *d = disk_get(chan_no, dev_no);
             if (d != NULL && d->is_ata)
-                printf("%s: %lld reads, %lld writes\n", d->name, d->read_cnt, d->write_cnt);
+                printf("%s: %lld reads, %lld writes, %lld commands\n", d->name, d->read_cnt,
+                       d->write_cnt, d->cmd_cnt);
         }
     }
 }
@@ -205,43 +207,70 @@ disk_sector_t disk_size(struct disk *d) {
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer) {
+    disk_read_multiple(d, sec_no, 1, &buffer);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer) {
+    disk_write_multiple(d, sec_no, 1, &buffer);
+}
+
+/* Reads the SEC_CNT sectors starting at SEC_NO from disk D with
+   a single command.  Sector SEC_NO + I goes into BUFFERS[I],
+   which must have room for DISK_SECTOR_SIZE bytes.  SEC_CNT must
+   be between 1 and DISK_MULTIPLE_MAX. */
+void disk_read_multiple(struct disk *d, disk_sector_t sec_no, size_t sec_cnt,
+                        void *const buffers[]) {
     struct channel *c;
 
     ASSERT(d != NULL);
-    ASSERT(buffer != NULL);
+    ASSERT(buffers != NULL);
+    ASSERT(sec_cnt > 0 && sec_cnt <= DISK_MULTIPLE_MAX);
 
     c = d->channel;
     lock_acquire(&c->lock);
-    select_sector(d, sec_no);
+    select_sector(d, sec_no, sec_cnt);
     issue_pio_command(c, CMD_READ_SECTOR_RETRY);
-    sema_down(&c->completion_wait);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
-    input_sector(c, buffer);
-    d->read_cnt++;
+    for (size_t i = 0; i < sec_cnt; i++) {
+        sema_down(&c->completion_wait);
+        if (!wait_while_busy(d))
+            PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no + (disk_sector_t)i);
+        input_sector(c, buffers[i]);
+    }
+    d->read_cnt += sec_cnt;
+    d->cmd_cnt++;
     lock_release(&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
-   Internally synchronizes accesses to disks, so external
-   per-disk locking is unneeded. */
-void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer) {
+/* Writes the SEC_CNT sectors starting at SEC_NO to disk D with a
+   single command.  Sector SEC_NO + I comes from BUFFERS[I], which
+   must contain DISK_SECTOR_SIZE bytes.  SEC_CNT must be between 1
+   and DISK_MULTIPLE_MAX.  Returns after the disk has acknowledged
+   receiving all of the data. */
+void disk_write_multiple(struct disk *d, disk_sector_t sec_no, size_t sec_cnt,
+                         const void *const buffers[]) {
     struct channel *c;
 
     ASSERT(d != NULL);
-    ASSERT(buffer != NULL);
+    ASSERT(buffers != NULL);
+    ASSERT(sec_cnt > 0 && sec_cnt <= DISK_MULTIPLE_MAX);
 
     c = d->channel;
     lock_acquire(&c->lock);
-    select_sector(d, sec_no);
+    select_sector(d, sec_no, sec_cnt);
     issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
-    output_sector(c, buffer);
-    sema_down(&c->completion_wait);
-    d->write_cnt++;
+    for (size_t i = 0; i < sec_cnt; i++) {
+        if (!wait_while_busy(d))
+            PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no + (disk_sector_t)i);
+        output_sector(c, buffers[i]);
+        sema_down(&c->completion_wait);
+    }
+    d->write_cnt += sec_cnt;
+    d->cmd_cnt++;
     lock_release(&c->lock);
 }
 
@@ -389,16 +418,16 @@ static void print_ata_string(char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
-static void select_sector(struct disk *d, disk_sector_t sec_no) {
+   writes SEC_NO and SEC_CNT to the disk's sector selection
+   registers.  (We use LBA mode.) */
+static void select_sector(struct disk *d, disk_sector_t sec_no, size_t sec_cnt) {
     struct channel *c = d->channel;
 
-    ASSERT(sec_no < d->capacity);
-    ASSERT(sec_no < (1UL << 28));
+    ASSERT(sec_no + sec_cnt <= d->capacity);
+    ASSERT(sec_no + sec_cnt <= (1UL << 28));
 
     select_device_wait(d);
-    outb(reg_nsect(c), 1);
+    outb(reg_nsect(c), sec_cnt == DISK_MULTIPLE_MAX ? 0 : sec_cnt);
     outb(reg_lbal(c), sec_no);
     outb(reg_lbam(c), sec_no >> 8);
     outb(reg_lbah(c), (sec_no >> 16));
@@ -5,10 +5,12 @@
 #include <round.h>
 #include <stdio.h>
 
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -22,11 +24,64 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* 8254 input frequency, and the counter value for one tick. */
+#define PIT_HZ 1193180
+static uint16_t tick_count;
+
+/* Tickless idle.  If true (set by kernel command-line option
+   "-tickless"), the idle thread stops the periodic tick and
+   programs a single interrupt for the next tick that has work
+   to do.  The 8254 counter is 16 bits wide, so one interrupt can
+   cover at most MAX_ONESHOT_TICKS ticks; a longer idle period is
+   covered by a chain of one-shots, each armed by the interrupt of
+   the one before, until its deadline. */
+bool timer_tickless;
+#define MAX_ONESHOT_TICKS (UINT16_MAX / ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ))
+static int oneshot_ticks;         /* Ticks covered by the armed one-shot, or 0. */
+static int64_t oneshot_deadline;  /* Tick that ends the idle period. */
+static bool oneshot_rearmed;      /* Did the last interrupt chain a one-shot? */
+static int64_t tickless_skipped;  /* # of ticks that raised no interrupt. */
+static int64_t tickless_entries;  /* # of idle periods with the tick stopped. */
+static int64_t tickless_capped;   /* # of those longer than one one-shot. */
+static int64_t tickless_rearms;   /* # of one-shots chained toward a deadline. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Hierarchical timer wheel holding pending timer events.
+
+   Level 0 has one slot per tick, level 1 one slot per 256 ticks
+   and level 2 one slot per 64K ticks; events further out than
+   that wait on wheel_overflow.  An event is filed by its absolute
+   expiry time, so adding and cancelling are O(1).  Each time the
+   level-0 index wraps around, the next level-1 slot is cascaded
+   down into level 0, and likewise for the upper levels, which
+   makes expiry amortized O(1) per event. */
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 3
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static struct list wheel_overflow;
+
+/* Next tick whose level-0 slot has not been run yet. */
+static int64_t wheel_time;
+
+/* True while wheel_run() fires the events of wheel_time's slot. */
+static bool wheel_draining;
+
+/* Timer interrupt handler cost, in TSC cycles. */
+static uint64_t intr_cycles_total;
+static uint64_t intr_cycles_max;
+
 static intr_handler_func timer_interrupt;
+static void pit_periodic(void);
+static void pit_oneshot(int n);
+static void tickless_stop(void);
+static void wheel_insert(struct timer_event *);
+static void wheel_cascade(struct list *);
+static void wheel_run(void);
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
@@ -37,11 +92,12 @@ static void real_time_sleep(int64_t num, int32_t denom);
 void timer_init(void) {
     /* 8254 input frequency divided by TIMER_FREQ, rounded to
        nearest. */
-    uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+    tick_count = (PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ;
+    pit_periodic();
 
-    outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-    outb(0x40, count & 0xff);
-    outb(0x40, count >> 8);
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+        for (int slot = 0; slot < WHEEL_SIZE; slot++) list_init(&wheel[level][slot]);
+    list_init(&wheel_overflow);
 
     intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
@@ -115,14 +171,278 @@ void timer_nsleep(int64_t ns) {
 
 /* Prints timer statistics. */
 void timer_print_stats(void) {
+    uint64_t max, avg;
+
+    timer_interrupt_cycles(&max, &avg);
     printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+    printf("Timer: interrupt handler %" PRIu64 " cycles max, %" PRIu64 " cycles avg\n", max,
+           avg);
+}
+
+/* Stores the largest and the mean number of TSC cycles spent in
+   the timer interrupt handler into *MAX and *AVG. */
+void timer_interrupt_cycles(uint64_t *max, uint64_t *avg) {
+    enum intr_level old_level = intr_disable();
+    *max = intr_cycles_max;
+    *avg = ticks > 0 ? intr_cycles_total / ticks : 0;
+    intr_set_level(old_level);
+}
+
+/* Prints tickless idle statistics. */
+void timer_print_tickless_stats(void) {
+    if (timer_tickless)
+        printf("Tickless: %" PRId64 " ticks skipped in %" PRId64 " idle periods, %" PRId64
+               " capped at %d ticks and re-armed %" PRId64 " times\n",
+               tickless_skipped, tickless_entries, tickless_capped, MAX_ONESHOT_TICKS,
+               tickless_rearms);
+}
+
+/* Called by the idle thread, with interrupts off, right before
+   it halts.  If tickless idle is enabled, replaces the periodic
+   tick by one-shot interrupts up to the next tick that has a
+   timer event to fire or wheel slots to cascade (or, under the
+   MLFQS, a load average to update). */
+void timer_idle_enter(void) {
+    int n;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!timer_tickless || oneshot_ticks > 0 || wheel_time != ticks + 1)
+        return;
+
+    /* A cascade boundary comes at least every WHEEL_SIZE ticks. */
+    for (n = 1; n < WHEEL_SIZE; n++) {
+        int64_t tick = ticks + n;
+        if ((tick & WHEEL_MASK) == 0 || !list_empty(&wheel[0][tick & WHEEL_MASK]) ||
+            (thread_mlfqs && tick % TIMER_FREQ == 0))
+            break;
+    }
+    if (n == 1)
+        return;
+
+    oneshot_deadline = ticks + n;
+    if (n > MAX_ONESHOT_TICKS) {
+        tickless_capped++;
+        n = MAX_ONESHOT_TICKS;
+    }
+    pit_oneshot(n);
+    tickless_entries++;
+}
+
+/* Called by the idle thread, with interrupts off, after an
+   interrupt woke it.  Returns true if that was a one-shot that
+   timer_interrupt() only chained toward the deadline, so that
+   the idle thread may halt again with the tick still stopped. */
+bool timer_idle_rearmed(void) {
+    bool rearmed = oneshot_rearmed && oneshot_ticks > 0;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    oneshot_rearmed = false;
+    return rearmed;
+}
+
+/* Called by the idle thread after it wakes up.  If some other
+   interrupt woke it before the one-shot expired, catches up
+   `ticks' and restores the periodic tick. */
+void timer_idle_exit(void) {
+    enum intr_level old_level = intr_disable();
+    tickless_stop();
+    intr_set_level(old_level);
+}
+
+/* Programs the 8254 to interrupt TIMER_FREQ times per second. */
+static void pit_periodic(void) {
+    outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
+    outb(0x40, tick_count & 0xff);
+    outb(0x40, tick_count >> 8);
+}
+
+/* Programs the 8254 to interrupt once, N ticks from now. */
+static void pit_oneshot(int n) {
+    uint16_t count = n * tick_count;
+
+    ASSERT(n > 0 && n <= MAX_ONESHOT_TICKS);
+
+    /* CW: counter 0, LSB then MSB, mode 0 (one-shot), binary. */
+    outb(0x43, 0x30);
+    outb(0x40, count & 0xff);
+    outb(0x40, count >> 8);
+    oneshot_ticks = n;
+}
+
+/* Cancels an armed one-shot before it expired: advances `ticks'
+   by the whole ticks that elapsed and restores the periodic
+   tick.  Fewer than `oneshot_ticks' ticks can have elapsed, and
+   timer_idle_enter() made sure none of them has work to do, so
+   the wheel just catches up on the next timer interrupt. */
+static void tickless_stop(void) {
+    uint16_t remaining, elapsed;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (oneshot_ticks == 0)
+        return;
+
+    outb(0x43, 0x00); /* CW: latch counter 0. */
+    remaining = inb(0x40);
+    remaining |= inb(0x40) << 8;
+    elapsed = (oneshot_ticks * tick_count - remaining) / tick_count;
+    if (elapsed >= oneshot_ticks)
+        elapsed = oneshot_ticks - 1;
+
+    ticks += elapsed;
+    tickless_skipped += elapsed;
+    oneshot_ticks = 0;
+    oneshot_rearmed = false;
+    pit_periodic();
+}
+
+/* Initializes timer event EV to call FUNC with AUX when it
+   expires.  EV is not pending until timer_event_add(). */
+void timer_event_init(struct timer_event *ev, timer_func *func, void *aux) {
+    ASSERT(ev != NULL);
+    ASSERT(func != NULL);
+
+    ev->expires = 0;
+    ev->func = func;
+    ev->aux = aux;
+    ev->pending = false;
+}
+
+/* Arms EV to fire at tick EXPIRES.  If EXPIRES has already
+   passed, EV fires on the next timer tick.  EV must not already
+   be pending.  May be called from an interrupt handler. */
+void timer_event_add(struct timer_event *ev, int64_t expires) {
+    enum intr_level old_level;
+
+    ASSERT(ev != NULL);
+
+    old_level = intr_disable();
+    ASSERT(!ev->pending);
+    tickless_stop();
+    ev->expires = expires;
+    ev->pending = true;
+    wheel_insert(ev);
+    intr_set_level(old_level);
+}
+
+/* Disarms EV.  Returns true if EV was pending, false if it had
+   already fired or was never added.  May be called from an
+   interrupt handler. */
+bool timer_event_cancel(struct timer_event *ev) {
+    enum intr_level old_level;
+    bool was_pending;
+
+    ASSERT(ev != NULL);
+
+    old_level = intr_disable();
+    was_pending = ev->pending;
+    if (was_pending) {
+        list_remove(&ev->elem);
+        ev->pending = false;
+    }
+    intr_set_level(old_level);
+    return was_pending;
+}
+
+/* Files EV into the wheel slot that covers its expiry time,
+   relative to wheel_time.  An event that is already due goes to
+   wheel_time's slot, or to the next one if a callback re-adds it
+   while that slot is being drained, so that it fires at most
+   once per tick. */
+static void wheel_insert(struct timer_event *ev) {
+    int64_t earliest = wheel_draining ? wheel_time + 1 : wheel_time;
+    int64_t expires = ev->expires < earliest ? earliest : ev->expires;
+    int64_t delta = expires - wheel_time;
+    struct list *slot;
+
+    if (delta < (1 << WHEEL_BITS))
+        slot = &wheel[0][expires & WHEEL_MASK];
+    else if (delta < (1 << (2 * WHEEL_BITS)))
+        slot = &wheel[1][(expires >> WHEEL_BITS) & WHEEL_MASK];
+    else if (delta < (1 << (3 * WHEEL_BITS)))
+        slot = &wheel[2][(expires >> (2 * WHEEL_BITS)) & WHEEL_MASK];
+    else
+        slot = &wheel_overflow;
+    list_push_back(slot, &ev->elem);
+}
+
+/* Moves every event in SLOT down to the level that now covers
+   it. */
+static void wheel_cascade(struct list *slot) {
+    struct list pending;
+
+    list_init(&pending);
+    while (!list_empty(slot)) list_push_back(&pending, list_pop_front(slot));
+    while (!list_empty(&pending))
+        wheel_insert(list_entry(list_pop_front(&pending), struct timer_event, elem));
+}
+
+/* Fires every event that expires at wheel_time, cascading the
+   upper levels first whenever a lower level wraps around, then
+   advances wheel_time. */
+static void wheel_run(void) {
+    int idx = wheel_time & WHEEL_MASK;
+    struct list *slot;
+
+    if (idx == 0) {
+        int idx1 = (wheel_time >> WHEEL_BITS) & WHEEL_MASK;
+        if (idx1 == 0) {
+            int idx2 = (wheel_time >> (2 * WHEEL_BITS)) & WHEEL_MASK;
+            if (idx2 == 0)
+                wheel_cascade(&wheel_overflow);
+            wheel_cascade(&wheel[2][idx2]);
+        }
+        wheel_cascade(&wheel[1][idx1]);
+    }
+
+    slot = &wheel[0][idx];
+    wheel_draining = true;
+    while (!list_empty(slot)) {
+        struct timer_event *ev = list_entry(list_pop_front(slot), struct timer_event, elem);
+        ev->pending = false;
+        ev->func(ev->aux);
+    }
+    wheel_draining = false;
+    wheel_time++;
 }
 
 /* Timer interrupt handler. */
 static void timer_interrupt(struct intr_frame *args UNUSED) {
+    uint64_t start = rdtsc();
+    uint64_t cycles;
+
+    /* A one-shot interrupt stands for every tick it covered.  Short
+       of the deadline, this tick has no work either, so just chain
+       the next one-shot. */
+    if (oneshot_ticks > 0) {
+        ticks += oneshot_ticks - 1;
+        tickless_skipped += oneshot_ticks - 1;
+        oneshot_ticks = 0;
+        if (ticks + 1 < oneshot_deadline) {
+            int64_t left;
+
+            ticks++;
+            tickless_skipped++;
+            left = oneshot_deadline - ticks;
+            pit_oneshot(left < MAX_ONESHOT_TICKS ? left : MAX_ONESHOT_TICKS);
+            oneshot_rearmed = true;
+            tickless_rearms++;
+            return;
+        }
+        pit_periodic();
+    }
+
     ticks++;
-    thread_awake();
+    trace(TRACE_TICK, thread_current()->tid, ticks);
+    while (wheel_time <= ticks) wheel_run();
     thread_tick();
+
+    cycles = rdtsc() - start;
+    intr_cycles_total += cycles;
+    if (cycles > intr_cycles_max)
+        intr_cycles_max = cycles;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -3,7 +3,7 @@
 #include <debug.h>
 
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* An open file. */
 struct file {
@@ -12,11 +12,21 @@ struct file {
     bool deny_write;     /* Has file_deny_write() been called? */
 };
 
+/* Cache of `struct file's. */
+static struct kmem_cache *file_cache;
+
+/* Initializes the file module. */
+void file_init(void) {
+    file_cache = kmem_cache_create("file", sizeof(struct file), NULL);
+    if (file_cache == NULL)
+        PANIC("cannot create file cache");
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
 struct file *file_open(struct inode *inode) {
-    struct file *file = calloc(1, sizeof *file);
+    struct file *file = kmem_cache_alloc(file_cache);
     if (inode != NULL && file != NULL) {
         file->inode = inode;
         file->pos = 0;
@@ -24,7 +34,7 @@ struct file *file_open(struct inode *inode) {
         return file;
     } else {
         inode_close(inode);
-        free(file);
+        kmem_cache_free(file_cache, file);
         return NULL;
     }
 }
@@ -52,7 +62,7 @@ void file_close(struct file *file) {
     if (file != NULL) {
         file_allow_write(file);
         inode_close(file->inode);
-        free(file);
+        kmem_cache_free(file_cache, file);
     }
 }
 
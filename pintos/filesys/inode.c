@@ -8,6 +8,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -50,12 +52,22 @@ static disk_sector_t byte_to_sector(const struct inode *inode, off_t pos) {
 }
 
 /* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
+ * returns the same `struct inode'.
+ * open_inodes_lock protects the list and every inode's open_cnt,
+ * since lookups run concurrently under a shared filesys_lock. */
 static struct list open_inodes;
+static struct lock open_inodes_lock;
+
+/* Cache of in-memory inodes. */
+static struct kmem_cache *inode_cache;
 
 /* Initializes the inode module. */
 void inode_init(void) {
     list_init(&open_inodes);
+    lock_init_named(&open_inodes_lock, "open inodes");
+    inode_cache = kmem_cache_create("inode", sizeof(struct inode), NULL);
+    if (inode_cache == NULL)
+        PANIC("cannot create inode cache");
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -101,19 +113,24 @@ struct inode *inode_open(disk_sector_t sector) {
     struct list_elem *e;
     struct inode *inode;
 
+    lock_acquire(&open_inodes_lock);
+
     /* Check whether this inode is already open. */
     for (e = list_begin(&open_inodes); e != list_end(&open_inodes); e = list_next(e)) {
         inode = list_entry(e, struct inode, elem);
         if (inode->sector == sector) {
-            inode_reopen(inode);
+            inode->open_cnt++;
+            lock_release(&open_inodes_lock);
             return inode;
         }
     }
 
     /* Allocate memory. */
-    inode = malloc(sizeof *inode);
-    if (inode == NULL)
+    inode = kmem_cache_alloc(inode_cache);
+    if (inode == NULL) {
+        lock_release(&open_inodes_lock);
         return NULL;
+    }
 
     /* Initialize. */
     list_push_front(&open_inodes, &inode->elem);
@@ -122,13 +139,17 @@ struct inode *inode_open(disk_sector_t sector) {
     inode->deny_write_cnt = 0;
     inode->removed = false;
     disk_read(filesys_disk, inode->sector, &inode->data);
+    lock_release(&open_inodes_lock);
     return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *inode_reopen(struct inode *inode) {
-    if (inode != NULL)
+    if (inode != NULL) {
+        lock_acquire(&open_inodes_lock);
         inode->open_cnt++;
+        lock_release(&open_inodes_lock);
+    }
     return inode;
 }
 
@@ -146,18 +167,23 @@ void inode_close(struct inode *inode) {
         return;
 
     /* Release resources if this was the last opener. */
-    if (--inode->open_cnt == 0) {
-        /* Remove from inode list and release lock. */
-        list_remove(&inode->elem);
-
-        /* Deallocate blocks if removed. */
-        if (inode->removed) {
-            free_map_release(inode->sector, 1);
-            free_map_release(inode->data.start, bytes_to_sectors(inode->data.length));
-        }
+    lock_acquire(&open_inodes_lock);
+    if (--inode->open_cnt > 0) {
+        lock_release(&open_inodes_lock);
+        return;
+    }
+
+    /* Remove from inode list and release lock. */
+    list_remove(&inode->elem);
+    lock_release(&open_inodes_lock);
 
-        free(inode);
+    /* Deallocate blocks if removed. */
+    if (inode->removed) {
+        free_map_release(inode->sector, 1);
+        free_map_release(inode->data.start, bytes_to_sectors(inode->data.length));
     }
+
+    kmem_cache_free(inode_cache, inode);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -291,6 +317,12 @@ void inode_allow_write(struct inode *inode) {
     inode->deny_write_cnt--;
 }
 
+/* Returns true if writes to INODE are denied, as they are while
+   it is a running executable. */
+bool inode_is_write_denied(const struct inode *inode) {
+    return inode->deny_write_cnt > 0;
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t inode_length(const struct inode *inode) {
     return inode->data.length;
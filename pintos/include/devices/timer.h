@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -20,4 +22,30 @@ void timer_nsleep(int64_t nanoseconds);
 
 void timer_print_stats(void);
 
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_idle_enter(void);
+void timer_idle_exit(void);
+bool timer_idle_rearmed(void);
+void timer_print_tickless_stats(void);
+
+/* Kernel timer event.  Once timer_ticks() reaches EXPIRES, FUNC
+   is called with AUX from the timer interrupt handler, that is,
+   in an external interrupt context with interrupts off.  FUNC
+   must not sleep. */
+typedef void timer_func(void *aux);
+
+struct timer_event {
+    struct list_elem elem; /* Element in a timer wheel slot. */
+    int64_t expires;       /* Tick at which to fire. */
+    timer_func *func;      /* Callback. */
+    void *aux;             /* Callback argument. */
+    bool pending;          /* Queued and not yet fired? */
+};
+
+void timer_event_init(struct timer_event *, timer_func *, void *aux);
+void timer_event_add(struct timer_event *, int64_t expires);
+bool timer_event_cancel(struct timer_event *);
+void timer_interrupt_cycles(uint64_t *max, uint64_t *avg);
+
 #endif /* devices/timer.h */
@@ -36,12 +36,40 @@ __attribute__((always_inline)) static __inline uint64_t read_eflags(void) {
     return rflags;
 }
 
+__attribute__((always_inline)) static __inline uint64_t rcr0(void) {
+    uint64_t val;
+    __asm __volatile("movq %%cr0,%0" : "=r"(val));
+    return val;
+}
+
+__attribute__((always_inline)) static __inline void lcr0(uint64_t val) {
+    __asm __volatile("movq %0, %%cr0" : : "r"(val));
+}
+
 __attribute__((always_inline)) static __inline uint64_t rcr3(void) {
     uint64_t val;
     __asm __volatile("movq %%cr3,%0" : "=r"(val));
     return val;
 }
 
+__attribute__((always_inline)) static __inline uint64_t rcr4(void) {
+    uint64_t val;
+    __asm __volatile("movq %%cr4,%0" : "=r"(val));
+    return val;
+}
+
+__attribute__((always_inline)) static __inline void lcr4(uint64_t val) {
+    __asm __volatile("movq %0, %%cr4" : : "r"(val));
+}
+
+/* Executes CPUID with EAX = LEAF and ECX = 0.  See [IA32-v2a]
+   "CPUID--CPU Identification". */
+__attribute__((always_inline)) static __inline void cpuid(uint32_t leaf, uint32_t *eax,
+                                                          uint32_t *ebx, uint32_t *ecx,
+                                                          uint32_t *edx) {
+    __asm __volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(leaf), "c"(0));
+}
+
 __attribute__((always_inline)) static __inline uint64_t rrax(void) {
     uint64_t val;
     __asm __volatile("movq %%rax,%0" : "=r"(val));
@@ -101,6 +129,12 @@ __attribute__((always_inline)) static __inline uint64_t rcr2(void) {
     return val;
 }
 
+__attribute__((always_inline)) static __inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm __volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return (uint64_t)hi << 32 | lo;
+}
+
 __attribute__((always_inline)) static __inline void write_msr(uint32_t ecx, uint64_t val) {
     uint32_t edx, eax;
     eax = (uint32_t)val;
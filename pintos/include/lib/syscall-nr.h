@@ -36,6 +36,12 @@ enum {
 
     SYS_MOUNT,
     SYS_UMOUNT,
+
+    /* Futexes. */
+    SYS_FUTEX_WAIT, /* Block while a word holds a value. */
+    SYS_FUTEX_WAKE, /* Wake threads blocked on a word. */
+
+    SYS_YIELD, /* Give the CPU to another ready process. */
 };
 
 #endif /* lib/syscall-nr.h */
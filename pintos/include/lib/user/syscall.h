@@ -16,6 +16,11 @@ typedef int off_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* futex_wait() results. */
+#define FUTEX_WOKEN 0     /* Woken by futex_wake(). */
+#define FUTEX_AGAIN -1    /* *ADDR did not hold EXPECTED. */
+#define FUTEX_TIMEDOUT -2 /* TIMEOUT ticks passed first. */
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0 /* Successful execution. */
 #define EXIT_FAILURE 1 /* Unsuccessful execution. */
@@ -38,6 +43,11 @@ void close(int fd);
 
 int dup2(int oldfd, int newfd);
 
+int futex_wait(unsigned *addr, unsigned expected, long long timeout);
+int futex_wake(unsigned *addr, int n);
+
+void yield(void);
+
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
@@ -76,4 +86,16 @@ static inline long long get_fs_disk_write_cnt(void) {
     return write_cnt;
 }
 
+/* Counters for get_vm_stat(). */
+#define VM_STAT_FAULTS 0    /* Page faults handled. */
+#define VM_STAT_EVICTIONS 1 /* Frames evicted. */
+#define VM_STAT_MSEC 2      /* Milliseconds since boot. */
+#define VM_STAT_STACK 3     /* This process's stack high-water mark, in bytes. */
+
+static inline long long get_vm_stat(long long which) {
+    long long value;
+    asm volatile("int $0x45" : "=a"(value) : "a"(which) : "memory");
+    return value;
+}
+
 #endif /* lib/user/syscall.h */
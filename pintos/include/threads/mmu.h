@@ -20,6 +20,12 @@ bool pml4_is_dirty(uint64_t *pml4, const void *upage);
 void pml4_set_dirty(uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed(uint64_t *pml4, const void *upage);
 void pml4_set_accessed(uint64_t *pml4, const void *upage, bool accessed);
+void pml4_set_writable(uint64_t *pml4, const void *upage, bool writable);
+void pml4_flush(uint64_t *pml4);
+
+extern bool pcid_enabled;
+void pcid_init(void);
+void pcid_print_stats(void);
 
 #define is_writable(pte) (*(pte) & PTE_W)
 #define is_user_pte(pte) (*(pte) & PTE_U)
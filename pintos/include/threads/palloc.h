@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -11,6 +12,10 @@ enum palloc_flags {
     PAL_USER = 004    /* User page. */
 };
 
+/* Number of buddy allocator block orders.  The largest block
+   is 2**(PAL_ORDER_CNT - 1) pages. */
+#define PAL_ORDER_CNT 20
+
 /* Maximum number of pages to put in user pool. */
 extern size_t user_page_limit;
 
@@ -19,5 +24,13 @@ void *palloc_get_page(enum palloc_flags);
 void *palloc_get_multiple(enum palloc_flags, size_t page_cnt);
 void palloc_free_page(void *);
 void palloc_free_multiple(void *, size_t page_cnt);
+bool palloc_grow(void *, size_t page_cnt, size_t new_cnt);
+void palloc_set_owner(void *, size_t page_cnt, void *owner);
+void *palloc_get_owner(void *);
+size_t palloc_free_blocks(enum palloc_flags, int order);
+size_t palloc_free_pages(enum palloc_flags);
+void palloc_pool_range(enum palloc_flags, void **base, size_t *page_cnt);
+bool palloc_prezero(void);
+void palloc_print_stats(void);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,21 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches.  A cache hands out objects of one fixed size,
+   packed into page-sized slabs.  See slab.c for details. */
+struct kmem_cache;
+
+/* Object constructor.  Called once for each object when its slab
+   is created, not on every allocation, so objects must be back in
+   their constructed state when they are freed. */
+typedef void kmem_ctor(void *obj);
+
+void kmem_init(void);
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, kmem_ctor *);
+void *kmem_cache_alloc(struct kmem_cache *) __attribute__((malloc));
+void kmem_cache_free(struct kmem_cache *, void *);
+void kmem_print_stats(void);
+
+#endif /* threads/slab.h */
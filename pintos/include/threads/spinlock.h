@@ -0,0 +1,27 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Spin lock.
+
+   Unlike a struct lock, a spin lock never sleeps, so it may be
+   used by interrupt handlers and by the scheduler itself.  It
+   must be held with interrupts off, so that the holder is not
+   preempted and an interrupt handler cannot spin forever on a
+   lock that the code it interrupted holds.  Pintos runs on one
+   CPU, so such a lock is never contended; it documents which
+   data the interrupts-off section protects and catches
+   recursive acquisition. */
+struct spinlock {
+    volatile uint32_t locked; /* Nonzero while held. */
+    const char *name;         /* Name (for debugging). */
+};
+
+void spinlock_init(struct spinlock *, const char *name);
+void spinlock_acquire(struct spinlock *);
+void spinlock_release(struct spinlock *);
+bool spinlock_held(const struct spinlock *);
+
+#endif /* threads/spinlock.h */
@@ -3,12 +3,29 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/* Contention statistics of a named lock, recorded while lock
+   profiling is enabled by kernel command-line option
+   "-lockstat".  Times are in TSC cycles. */
+struct lock_stats {
+    const char *name;         /* Name, or NULL if not profiled. */
+    uint64_t acquisitions;    /* # of times acquired. */
+    uint64_t contended;       /* # of acquisitions that had to wait. */
+    uint64_t wait_cycles;     /* Total time spent waiting. */
+    uint64_t max_hold_cycles; /* Longest time held. */
+    uint64_t acquired_at;     /* When last acquired. */
+    struct list_elem elem;    /* Element in the list of named locks. */
+};
+
+extern bool lock_profiling;
 
 /* 세마포어 구조체 정의부분 */
 struct semaphore {
     unsigned value; /* Current value. */
     int priority;
-    struct list waiters; /* List of waiting threads. */
+    struct list waiters;      /* List of waiting threads. */
+    struct lock_stats *stats; /* Where sema_down() records waits, or NULL. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -21,14 +38,53 @@ void sema_self_test (void);
 struct lock {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct lock_stats stats;    /* Contention statistics. */
 };
 
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
+void lock_print_stats (void);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Readers-writer lock.
+
+   Any number of readers, or a single writer, may hold the lock.
+   Arriving readers queue behind a waiting writer, so writers are
+   not starved, and a releasing writer admits every reader that
+   was waiting before the next writer, so readers are not starved
+   either.  Waiters donate their priority to every holder. */
+struct rwlock {
+    struct thread *writer;     /* Thread holding write access, or NULL. */
+    int readers;               /* # of threads holding read access. */
+    struct list holders;       /* struct rwlock_hold of every holder. */
+    struct list read_waiters;  /* Threads waiting for read access. */
+    struct list write_waiters; /* Threads waiting for write access. */
+    struct lock_stats stats;   /* Contention statistics. */
+};
+
+/* One rwlock held by a thread.  Each thread has RWLOCK_HOLD_MAX
+   of these, so that a holder can be found to receive donations
+   and its priority can be recomputed on release.  A thread may
+   hold at most that many rwlocks at once; acquiring one more is
+   a kernel bug and fails an assertion. */
+#define RWLOCK_HOLD_MAX 4
+struct rwlock_hold {
+    struct rwlock *rwlock;  /* Held rwlock, or NULL if unused. */
+    struct thread *thread;  /* Holding thread. */
+    struct list_elem elem;  /* Element in rwlock's `holders'. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_init_named (struct rwlock *, const char *name);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
     struct list waiters; /* List of waiting threads. */
@@ -5,6 +5,7 @@
 #include <list.h>
 #include <stdint.h>
 
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #define FDT_MAX_SIZE 128
@@ -30,6 +31,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* Thread niceness, for the MLFQS. */
+#define NICE_MIN -20    /* Most favorable to others. */
+#define NICE_DEFAULT 0  /* Default niceness. */
+#define NICE_MAX 20     /* Least favorable to others. */
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -98,6 +104,12 @@ struct thread {
     struct list donation_list;
     struct list_elem donation_elem;
     struct lock *wait_on_lock;
+    struct rwlock_hold rwlock_holds[RWLOCK_HOLD_MAX]; /* Held rwlocks. */
+
+    /* Owned by thread.c, used only by the MLFQS. */
+    int nice;                 /* Niceness. */
+    fixed_t recent_cpu;       /* Recent CPU time received. */
+    struct list_elem allelem; /* List element for all threads list. */
 
     // elem 의 멤버 : struct list elem* prev,next => 쓰레드끼리 연결고리 역할
     struct list_elem elem;
@@ -132,8 +144,9 @@ struct thread {
 #ifdef VM
     /* Table for whole virtual memory owned by thread. */
     struct supplemental_page_table spt;
-    /* setup_stack */
+    /* setup_stack: 스택의 가장 낮은 페이지 (= 스택 최고 수위) */
     void *stack_bottom;
+    /* 시스템 콜에 들어올 때의 사용자 rsp, 커널 모드 fault에서 스택 성장 판단용 */
     void *rsp_stack;
 #endif
 
@@ -155,6 +168,8 @@ void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+long long thread_switch_count(void);
+void thread_cache_enable(bool);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
@@ -171,6 +186,7 @@ void thread_yield(void);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_change_priority(struct thread *, int priority);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
@@ -180,9 +196,7 @@ int thread_get_load_avg(void);
 void do_iret(struct intr_frame *tf);
 
 void thread_sleep(int64_t);
-void thread_awake();
 
-bool wake_early(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 bool higher_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 bool lower_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 int get_high_donation(struct thread *t);
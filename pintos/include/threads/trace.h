@@ -0,0 +1,39 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Scheduler event tracing.
+
+   When enabled by the "-trace" kernel command-line option,
+   scheduler events are recorded, stamped with the TSC, into a
+   fixed-size ring buffer that keeps the most recent TRACE_SIZE
+   events.  Recording takes no lock, so it is safe from interrupt
+   handlers and from inside the scheduler.  The buffer is dumped
+   as CSV over the console at power off; utils/trace2json turns
+   the dump into Chrome trace-event JSON. */
+
+/* Kinds of traced events, with the meaning of their TID and ARG. */
+enum trace_type {
+    TRACE_SCHEDULE, /* Switch from thread TID to thread ARG. */
+    TRACE_UNBLOCK,  /* Thread TID made ready, with priority ARG. */
+    TRACE_DONATE,   /* Thread TID raised to donated priority ARG. */
+    TRACE_SLEEP,    /* Thread TID sleeps for ARG ticks. */
+    TRACE_TICK,     /* Timer tick ARG, with thread TID running. */
+};
+
+extern bool trace_enabled;
+
+void trace_init(void);
+void trace_record(enum trace_type, int tid, int arg);
+void trace_dump(void);
+
+/* Records an event if tracing is enabled.  The check is inline so
+   that tracing costs a single branch when it is off. */
+static inline void trace(enum trace_type type, int tid, int arg) {
+    if (trace_enabled)
+        trace_record(type, tid, arg);
+}
+
+#endif /* threads/trace.h */
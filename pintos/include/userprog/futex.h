@@ -0,0 +1,15 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include <stdint.h>
+
+/* futex_wait() results.  Must agree with lib/user/syscall.h. */
+#define FUTEX_WOKEN 0     /* Woken by futex_wake(). */
+#define FUTEX_AGAIN -1    /* The word did not hold the expected value. */
+#define FUTEX_TIMEDOUT -2 /* The timeout expired first. */
+
+void futex_init(void);
+int futex_wait(uint32_t *uaddr, uint32_t expected, int64_t timeout);
+int futex_wake(uint32_t *uaddr, int n);
+
+#endif /* userprog/futex.h */
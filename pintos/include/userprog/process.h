@@ -9,6 +9,9 @@ int process_exec(void *f_name);
 int process_wait(tid_t);
 void process_exit(void);
 void process_activate(struct thread *next);
+void process_cow_init(void);
+bool process_cow_fault(void *addr);
+bool process_check_access(void *addr, bool write);
 // process_exec()에서 사용할 함수 선언
 // static void argument_stack(char **argv, int argc, struct intr_frame *if_);
 static void argument_stack(char **argv, int argc, struct intr_frame *if_, void *buffer);
@@ -4,13 +4,23 @@
 #include "vm/vm.h"
 
 struct page;
+struct zswap_entry;
 enum vm_type;
 
+/* Most pages written to or read from swap in one disk command. */
+#define SWAP_CLUSTER 8
+
 struct anon_page {
-    size_t swap_slot;
+    size_t swap_slot;           /* Swap slot holding the page, or SIZE_MAX. */
+    struct zswap_entry *zentry; /* Compressed copy in zswap, or NULL. */
 };
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+bool anon_swap_out_cluster(struct page *pages[], size_t cnt);
+bool anon_write_swap(void *const kvas[], size_t cnt, size_t slots[]);
+void anon_free_slot(size_t slot);
+void anon_read_swap(struct page *page, void *kva);
+void anon_print_stats(void);
 
 #endif
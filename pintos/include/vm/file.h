@@ -6,10 +6,17 @@
 struct page;
 enum vm_type;
 
-struct file_page {};
+/* A page of a file mapping.  Holds READ_BYTES bytes of FILE, the
+ * handle of the page's VMA, from OFS; the rest is zeros. */
+struct file_page {
+    struct file *file;
+    off_t ofs;
+    size_t read_bytes;
+};
 
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset);
 void do_munmap(void *va);
+void file_print_stats(void);
 #endif
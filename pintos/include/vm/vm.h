@@ -8,6 +8,7 @@
 #include "vm/file.h"
 #include "vm/uninit.h"
 #include "vm/vm_enum.h"
+#include "vm/vma.h"
 
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
@@ -34,6 +35,9 @@ struct page {
     void *va;            /* Address in terms of user space */
     struct frame *frame; /* Back reference for frame */
 
+    // 같은 프레임을 copy-on-write로 공유하는 다음 페이지
+    struct page *next_sharer;
+
     // Supplement table에서 사용함
     struct hash_elem hash_elem;
 
@@ -53,13 +57,25 @@ struct page {
     };
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * vm_init() builds one for every page of the user pool, in an array
+ * indexed by (kva - user pool base) / PGSIZE.  After fork() a frame
+ * may be shared copy-on-write: PAGE is then the first of a list of
+ * pages chained through `next_sharer', all mapped read-only.  A
+ * frame holding a file page is also entered in a cache by (INODE,
+ * OFS), so that other mappings of the same page share it; writable
+ * mappings then see each other's writes, like MAP_SHARED. */
 struct frame {
     void *kva;
     struct page *page;
 
-    // frame_table Push 및 페이지 교체 알고리즘을 적용하기 위해 추가함
-    struct list_elem elem;
+    // 채우는 중이거나 내보내는 중인 프레임은 clock이 건너뜀
+    bool pinned;
+
+    struct inode *inode;         /* Cached file page, or NULL. */
+    off_t ofs;
+    size_t read_bytes;           /* Bytes of the file in it; zeros after. */
+    struct hash_elem cache_elem; /* frame_cache element. */
 };
 
 /* The function table for page operations.
@@ -84,6 +100,10 @@ struct page_operations {
  * All designs up to you for this. */
 struct supplemental_page_table {
     struct hash spt_hash;
+
+    // 아직 페이지를 만들지 않은 영역 (struct vma, 시작 주소 순)
+    struct list vmas;
+    struct vma *vma_cache; /* Last VMA vma_find() returned. */
 };
 
 #include "threads/thread.h"
@@ -92,11 +112,21 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
                                   struct supplemental_page_table *src);
 void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
+struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
+/* How far user stacks may grow below USER_STACK, in bytes. */
+extern size_t vm_stack_max;
+
 void vm_init(void);
+void vm_print_stats(void);
+struct frame *vm_frame_of(void *kva);
+struct frame *vm_get_free_frame(void);
+bool vm_map_frame(struct page *page, struct frame *frame);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write, bool not_present);
+bool vm_check_access(void *addr, bool write);
+void vm_invalidate_file_frames(struct inode *inode, off_t ofs, off_t size);
 
 #define vm_alloc_page(type, upage, writable) \
     vm_alloc_page_with_initializer((type), (upage), (writable), NULL, NULL)
@@ -0,0 +1,41 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "filesys/off_t.h"
+#include "vm/uninit.h"
+#include "vm/vm_enum.h"
+
+struct file;
+struct supplemental_page_table;
+
+/* A virtual memory area: the pages [START, END) of a process, whose
+ * `struct page's are only created when first looked up.  The page
+ * at START + N holds the bytes of FILE from OFS + N, up to the first
+ * READ_BYTES bytes of the area, and zeros after them.  INIT, if not
+ * null, fills the page from a `struct lazy_segment_arg' it must
+ * free; otherwise the page's type reads the file itself. */
+struct vma {
+    void *start;
+    void *end;
+    struct file *file;    /* The area's own handle, closed with it. */
+    off_t ofs;
+    size_t read_bytes;
+    bool writable;
+    enum vm_type type;    /* Type of the pages created. */
+    vm_initializer *init;
+    struct list_elem elem; /* supplemental_page_table's `vmas', by START. */
+};
+
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length, bool writable,
+             enum vm_type type, struct file *file, off_t ofs, size_t read_bytes,
+             vm_initializer *init);
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va);
+size_t vma_read_bytes(const struct vma *vma, const void *va);
+struct page *vma_create_page(struct vma *vma, void *va);
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma);
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+void vma_destroy_all(struct supplemental_page_table *spt);
+#endif /* vm/vma.h */
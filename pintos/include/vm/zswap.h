@@ -0,0 +1,22 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct zswap_entry;
+
+/* Most pages of kernel memory the compressed store may hold before
+   it writes its oldest pages to the swap disk.  SIZE_MAX picks a
+   default from the size of the user pool; 0 disables the store. */
+extern size_t zswap_max_pages;
+
+void zswap_init(void);
+bool zswap_store(struct page *page);
+bool zswap_load(struct page *page, void *kva);
+bool zswap_copy(struct page *page, void *kva);
+void zswap_drop(struct page *page);
+void zswap_shrink(void);
+void zswap_print_stats(void);
+
+#endif /* vm/zswap.h */
@@ -25,10 +25,18 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   A bitmap may also have a summary, with one bit per element of
+   `bits' that is set iff every bit in that element is true.
+   Searches for false bits use it to skip ELEM_BITS full
+   elements at a time.  Keeping the summary exact takes a second
+   update after every change, so unlike plain bitmaps, bitmaps
+   with a summary must not be modified concurrently. */
 struct bitmap {
     size_t bit_cnt;  /* Number of bits. */
     elem_type *bits; /* Elements that represent bits. */
+    elem_type *full; /* Summary of full elements, or null. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -60,6 +68,87 @@ static inline elem_type last_mask(const struct bitmap *b) {
     return last_bits ? ((elem_type)1 << last_bits) - 1 : (elem_type)-1;
 }
 
+/* Returns the bits of element E that are set to VALUE. */
+static inline elem_type elem_value_bits(elem_type e, bool value) {
+    return value ? e : ~e;
+}
+
+/* Returns a mask of the CNT bits starting at bit OFS in an
+   element.  OFS + CNT must not exceed ELEM_BITS. */
+static inline elem_type range_mask(size_t ofs, size_t cnt) {
+    elem_type mask = cnt < ELEM_BITS ? ((elem_type)1 << cnt) - 1 : (elem_type)-1;
+    return mask << ofs;
+}
+
+/* Returns the number of bits set in E. */
+static inline size_t elem_popcount(elem_type e) {
+    e = e - ((e >> 1) & 0x5555555555555555);
+    e = (e & 0x3333333333333333) + ((e >> 2) & 0x3333333333333333);
+    e = (e + (e >> 4)) & 0x0f0f0f0f0f0f0f0f;
+    return (e * 0x0101010101010101) >> 56;
+}
+
+/* Atomically sets the bits in MASK in *E. */
+static inline void elem_or(elem_type *e, elem_type mask) {
+    asm("lock orq %1, %0" : "+m"(*e) : "r"(mask) : "cc");
+}
+
+/* Atomically clears the bits in MASK in *E. */
+static inline void elem_and_not(elem_type *e, elem_type mask) {
+    asm("lock andq %1, %0" : "+m"(*e) : "r"(~mask) : "cc");
+}
+
+/* Brings the summary bit for element IDX of B, if B has a
+   summary, up to date. */
+static inline void summary_update(struct bitmap *b, size_t idx) {
+    if (b->full != NULL) {
+        elem_type mask = idx == elem_cnt(b->bit_cnt) - 1 ? last_mask(b) : (elem_type)-1;
+
+        if ((b->bits[idx] & mask) == mask)
+            b->full[elem_idx(idx)] |= bit_mask(idx);
+        else
+            b->full[elem_idx(idx)] &= ~bit_mask(idx);
+    }
+}
+
+/* Returns the index of the first element of B at or after IDX
+   that has a false bit, according to B's summary, or the number
+   of elements in B if there is none. */
+static size_t next_nonfull_elem(const struct bitmap *b, size_t idx) {
+    size_t cnt = elem_cnt(b->bit_cnt);
+
+    while (idx < cnt) {
+        elem_type nonfull = ~b->full[elem_idx(idx)] & ((elem_type)-1 << (idx % ELEM_BITS));
+
+        if (nonfull != 0) {
+            idx = idx / ELEM_BITS * ELEM_BITS + __builtin_ctzl(nonfull);
+            return idx < cnt ? idx : cnt;
+        }
+        idx = (elem_idx(idx) + 1) * ELEM_BITS;
+    }
+    return cnt;
+}
+
+/* Returns the index of the first bit in B between START and
+   END, exclusive, that is set to VALUE, or END if there is
+   none.  Examines a whole element at a time. */
+static size_t find_next(const struct bitmap *b, size_t start, size_t end, bool value) {
+    while (start < end) {
+        size_t idx = elem_idx(start);
+        elem_type bits = elem_value_bits(b->bits[idx], value) & ((elem_type)-1 << (start % ELEM_BITS));
+
+        if (bits != 0) {
+            start = idx * ELEM_BITS + __builtin_ctzl(bits);
+            return start < end ? start : end;
+        }
+        if (!value && b->full != NULL)
+            start = next_nonfull_elem(b, idx + 1) * ELEM_BITS;
+        else
+            start = (idx + 1) * ELEM_BITS;
+    }
+    return end;
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -70,6 +159,7 @@ struct bitmap *bitmap_create(size_t bit_cnt) {
     struct bitmap *b = malloc(sizeof *b);
     if (b != NULL) {
         b->bit_cnt = bit_cnt;
+        b->full = NULL;
         b->bits = malloc(byte_cnt(bit_cnt));
         if (b->bits != NULL || bit_cnt == 0) {
             bitmap_set_all(b, false);
@@ -90,6 +180,7 @@ struct bitmap *bitmap_create_in_buf(size_t bit_cnt, void *block, size_t block_si
 
     b->bit_cnt = bit_cnt;
     b->bits = (elem_type *)(b + 1);
+    b->full = NULL;
     bitmap_set_all(b, false);
     return b;
 }
@@ -105,11 +196,30 @@ size_t bitmap_buf_size(size_t bit_cnt) {
    bitmap_create_preallocated(). */
 void bitmap_destroy(struct bitmap *b) {
     if (b != NULL) {
+        free(b->full);
         free(b->bits);
         free(b);
     }
 }
 
+/* Gives B a summary of its full elements, which speeds up
+   searches for false bits in large, mostly full bitmaps.  B must
+   not be modified concurrently from then on.  Returns true if
+   successful, false if memory allocation failed. */
+bool bitmap_enable_summary(struct bitmap *b) {
+    size_t cnt;
+
+    ASSERT(b != NULL);
+    cnt = elem_cnt(b->bit_cnt);
+    if (b->full == NULL) {
+        b->full = calloc(elem_cnt(cnt), sizeof *b->full);
+        if (b->full == NULL && cnt > 0)
+            return false;
+        for (size_t i = 0; i < cnt; i++) summary_update(b, i);
+    }
+    return true;
+}
+
 /* Bitmap size. */
 
 /* Returns the number of bits in B. */
@@ -137,7 +247,8 @@ void bitmap_mark(struct bitmap *b, size_t bit_idx) {
     /* This is equivalent to `b->bits[idx] |= mask' except that it
        is guaranteed to be atomic on a uniprocessor machine.  See
        the description of the OR instruction in [IA32-v2b]. */
-    asm("lock orq %1, %0" : "=m"(b->bits[idx]) : "r"(mask) : "cc");
+    elem_or(&b->bits[idx], mask);
+    summary_update(b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -148,7 +259,8 @@ void bitmap_reset(struct bitmap *b, size_t bit_idx) {
     /* This is equivalent to `b->bits[idx] &= ~mask' except that it
        is guaranteed to be atomic on a uniprocessor machine.  See
        the description of the AND instruction in [IA32-v2a]. */
-    asm("lock andq %1, %0" : "=m"(b->bits[idx]) : "r"(~mask) : "cc");
+    elem_and_not(&b->bits[idx], mask);
+    summary_update(b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -161,7 +273,8 @@ void bitmap_flip(struct bitmap *b, size_t bit_idx) {
     /* This is equivalent to `b->bits[idx] ^= mask' except that it
        is guaranteed to be atomic on a uniprocessor machine.  See
        the description of the XOR instruction in [IA32-v2b]. */
-    asm("lock xorq %1, %0" : "=m"(b->bits[idx]) : "r"(mask) : "cc");
+    asm("lock xorq %1, %0" : "+m"(b->bits[idx]) : "r"(mask) : "cc");
+    summary_update(b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -180,46 +293,56 @@ void bitmap_set_all(struct bitmap *b, bool value) {
     bitmap_set_multiple(b, 0, bitmap_size(b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, a whole element at a
+   time. */
 void bitmap_set_multiple(struct bitmap *b, size_t start, size_t cnt, bool value) {
-    size_t i;
+    size_t end = start + cnt;
 
     ASSERT(b != NULL);
     ASSERT(start <= b->bit_cnt);
     ASSERT(start + cnt <= b->bit_cnt);
 
-    for (i = 0; i < cnt; i++) bitmap_set(b, start + i, value);
+    while (start < end) {
+        size_t idx = elem_idx(start), ofs = start % ELEM_BITS;
+        size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+
+        if (value)
+            elem_or(&b->bits[idx], range_mask(ofs, n));
+        else
+            elem_and_not(&b->bits[idx], range_mask(ofs, n));
+        summary_update(b, idx);
+        start += n;
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t bitmap_count(const struct bitmap *b, size_t start, size_t cnt, bool value) {
-    size_t i, value_cnt;
+    size_t end = start + cnt, value_cnt = 0;
 
     ASSERT(b != NULL);
     ASSERT(start <= b->bit_cnt);
     ASSERT(start + cnt <= b->bit_cnt);
 
-    value_cnt = 0;
-    for (i = 0; i < cnt; i++)
-        if (bitmap_test(b, start + i) == value)
-            value_cnt++;
+    while (start < end) {
+        size_t idx = elem_idx(start), ofs = start % ELEM_BITS;
+        size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+
+        value_cnt += elem_popcount(elem_value_bits(b->bits[idx], value) & range_mask(ofs, n));
+        start += n;
+    }
     return value_cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
    exclusive, are set to VALUE, and false otherwise. */
 bool bitmap_contains(const struct bitmap *b, size_t start, size_t cnt, bool value) {
-    size_t i;
-
     ASSERT(b != NULL);
     ASSERT(start <= b->bit_cnt);
     ASSERT(start + cnt <= b->bit_cnt);
 
-    for (i = 0; i < cnt; i++)
-        if (bitmap_test(b, start + i) == value)
-            return true;
-    return false;
+    return find_next(b, start, start + cnt, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -245,17 +368,34 @@ bool bitmap_all(const struct bitmap *b, size_t start, size_t cnt) {
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Rather than testing every starting index, jumps to the next
+   bit set to VALUE, then to the next bit set to !VALUE after it;
+   if the run between them is too short, the search resumes past
+   its end.  Each jump examines a whole element at a time, so the
+   search takes time proportional to the number of elements (or
+   to the number of non-full elements, with a summary), whatever
+   CNT is. */
 size_t bitmap_scan(const struct bitmap *b, size_t start, size_t cnt, bool value) {
     ASSERT(b != NULL);
     ASSERT(start <= b->bit_cnt);
 
     if (cnt <= b->bit_cnt) {
         size_t last = b->bit_cnt - cnt;
-        size_t i;
-        for (i = start; i <= last; i++)
-            if (!bitmap_contains(b, i, cnt, !value))
+        size_t i = start, run_end;
+
+        if (cnt == 0)
+            return start;
+        while (i <= last) {
+            i = find_next(b, i, b->bit_cnt, value);
+            if (i > last)
+                break;
+            run_end = find_next(b, i, i + cnt, !value);
+            if (run_end == i + cnt)
                 return i;
+            i = run_end + 1;
+        }
     }
     return BITMAP_ERROR;
 }
@@ -290,6 +430,7 @@ bool bitmap_read(struct bitmap *b, struct file *file) {
         off_t size = byte_cnt(b->bit_cnt);
         success = file_read_at(file, b->bits, size, 0) == size;
         b->bits[elem_cnt(b->bit_cnt) - 1] &= last_mask(b);
+        for (size_t i = 0; i < elem_cnt(b->bit_cnt); i++) summary_update(b, i);
     }
     return success;
 }
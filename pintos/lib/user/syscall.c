@@ -154,3 +154,15 @@ int mount(const char *path, int chan_no, int dev_no) {
 int umount(const char *path) {
     return syscall1(SYS_UMOUNT, path);
 }
+
+int futex_wait(unsigned *addr, unsigned expected, long long timeout) {
+    return syscall3(SYS_FUTEX_WAIT, addr, expected, timeout);
+}
+
+int futex_wake(unsigned *addr, int n) {
+    return syscall2(SYS_FUTEX_WAKE, addr, n);
+}
+
+void yield(void) {
+    syscall0(SYS_YIELD);
+}
@@ -0,0 +1,154 @@
+/* Arms thousands of concurrent timer events, with expiry times
+   spread over every level of the timer wheel, while a few dozen
+   threads also sleep with timer_sleep().  Verifies that every
+   event fires exactly on its expiry tick, that cancelled events
+   never fire, that an event re-added as already due from its own
+   callback fires once per tick, and reports how long the timer
+   interrupt handler took. */
+
+#include <random.h>
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define EVENT_CNT 4000   /* Near events, fired during the test. */
+#define FAR_CNT 1000     /* Far events, cancelled at the end. */
+#define SPREAD 300       /* Near events expire within this many ticks. */
+#define FAR_MIN (10 * SPREAD) /* Far events expire no sooner, long after the test ends. */
+#define THREAD_CNT 32
+#define REPEAT_CNT 20    /* Times the repeating event fires. */
+
+/* A timer event plus what it saw when it fired. */
+struct alarm {
+    struct timer_event event;
+    int64_t fired_at; /* Tick at which it fired, or -1. */
+};
+
+/* A timer event that re-adds itself, already due, when it fires. */
+struct repeater {
+    struct timer_event event;
+    int fire_cnt;      /* Times it fired. */
+    int64_t last_tick; /* Tick at which it last fired. */
+    int same_tick_cnt; /* Times it fired twice in one tick. */
+};
+
+static timer_func alarm_fired;
+static timer_func repeater_fired;
+static thread_func sleeper;
+
+static struct semaphore sleepers_done;
+
+void test_alarm_many(void) {
+    struct alarm *alarms;
+    struct repeater repeater = {.fire_cnt = 0, .same_tick_cnt = 0};
+    int64_t start;
+    uint64_t max, avg;
+    int i, late;
+
+    /* This test does not work with the MLFQS. */
+    ASSERT(!thread_mlfqs);
+
+    msg("Arming %d timer events and %d far events.", EVENT_CNT, FAR_CNT);
+    msg("Starting %d sleeping threads.", THREAD_CNT);
+
+    alarms = malloc(sizeof *alarms * (EVENT_CNT + FAR_CNT));
+    if (alarms == NULL)
+        PANIC("couldn't allocate memory for test");
+
+    /* Make sure we're at the beginning of a timer tick. */
+    timer_sleep(1);
+    start = timer_ticks();
+
+    for (i = 0; i < EVENT_CNT + FAR_CNT; i++) {
+        struct alarm *a = &alarms[i];
+        int64_t delay;
+
+        if (i < EVENT_CNT)
+            delay = 1 + random_ulong() % SPREAD;
+        else
+            delay = FAR_MIN + random_ulong() % (1 << 25);
+        a->fired_at = -1;
+        timer_event_init(&a->event, alarm_fired, a);
+        timer_event_add(&a->event, start + delay);
+    }
+    timer_event_init(&repeater.event, repeater_fired, &repeater);
+    timer_event_add(&repeater.event, start + 1);
+
+    sema_init(&sleepers_done, 0);
+    for (i = 0; i < THREAD_CNT; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "sleeper %d", i);
+        thread_create(name, PRI_DEFAULT, sleeper, (void *)(intptr_t)(1 + i * SPREAD / THREAD_CNT));
+    }
+    for (i = 0; i < THREAD_CNT; i++) sema_down(&sleepers_done);
+
+    /* Wait for the last near event. */
+    timer_sleep(start + SPREAD + 1 - timer_ticks());
+
+    late = 0;
+    for (i = 0; i < EVENT_CNT; i++) {
+        struct alarm *a = &alarms[i];
+        if (a->fired_at < 0)
+            fail("event %d due at tick %lld never fired", i, a->event.expires);
+        if (a->fired_at != a->event.expires)
+            late++;
+    }
+    if (late > 0)
+        fail("%d events did not fire on their expiry tick", late);
+    msg("All near events fired on their expiry tick.");
+
+    for (i = EVENT_CNT; i < EVENT_CNT + FAR_CNT; i++) {
+        struct alarm *a = &alarms[i];
+        if (a->fired_at >= 0 || !timer_event_cancel(&a->event))
+            fail("far event %d fired early", i);
+    }
+    msg("All far events cancelled before firing.");
+
+    if (repeater.fire_cnt != REPEAT_CNT || repeater.same_tick_cnt != 0)
+        fail("repeating event fired %d times, %d of them twice in one tick", repeater.fire_cnt,
+             repeater.same_tick_cnt);
+    msg("The repeating event fired once per tick.");
+
+    timer_interrupt_cycles(&max, &avg);
+    printf("alarm-many: timer interrupt %llu cycles max, %llu cycles avg\n",
+           (unsigned long long)max, (unsigned long long)avg);
+
+    free(alarms);
+}
+
+/* Records the tick at which the alarm fired. */
+static void alarm_fired(void *a_) {
+    struct alarm *a = a_;
+    a->fired_at = timer_ticks();
+}
+
+/* Counts a firing of the repeater and, until it has fired
+   REPEAT_CNT times, re-adds it with an expiry time that has
+   already arrived. */
+static void repeater_fired(void *r_) {
+    struct repeater *r = r_;
+    int64_t now = timer_ticks();
+
+    if (r->fire_cnt > 0 && r->last_tick == now)
+        r->same_tick_cnt++;
+    r->last_tick = now;
+    if (++r->fire_cnt < REPEAT_CNT)
+        timer_event_add(&r->event, now);
+}
+
+/* Sleeps for the number of ticks given by AUX and checks that
+   it woke up no earlier than that. */
+static void sleeper(void *duration_) {
+    int64_t duration = (intptr_t)duration_;
+    int64_t start = timer_ticks();
+
+    timer_sleep(duration);
+    if (timer_elapsed(start) < duration)
+        fail("thread %s woke up early", thread_name());
+    sema_up(&sleepers_done);
+}
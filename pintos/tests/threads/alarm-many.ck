@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The interrupt handler timing line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^alarm-many: /, @output);
+fail "missing interrupt handler timing in output" if @stats != 1;
+fail "malformed interrupt handler timing: $stats[0]"
+  unless $stats[0] =~ /^alarm-many: timer interrupt \d+ cycles max, \d+ cycles avg$/;
+
+common_checks ("run", @output);
+compare_output ("run", [grep (!/^alarm-many: /, @output)], [<<'EOF']);
+(alarm-many) begin
+(alarm-many) Arming 4000 timer events and 1000 far events.
+(alarm-many) Starting 32 sleeping threads.
+(alarm-many) All near events fired on their expiry tick.
+(alarm-many) All far events cancelled before firing.
+(alarm-many) The repeating event fired once per tick.
+(alarm-many) end
+EOF
+pass;
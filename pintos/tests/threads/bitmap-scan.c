@@ -0,0 +1,116 @@
+/* Checks bitmap_scan() and bitmap_count() against simple
+   bit-by-bit versions on random bitmaps, with and without a
+   summary.  Then times a search for free sectors in a 1M-bit,
+   mostly full bitmap, the size of the free map for a 512 MB
+   disk, with the bit-by-bit scan, the word-at-a-time scan and
+   the word-at-a-time scan with a summary. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+#define BIG_BITS (1024 * 1024)
+#define RUN_CNT 8
+
+static size_t naive_scan(const struct bitmap *, size_t start, size_t cnt, bool value);
+static void check_random(bool summary);
+static uint64_t time_scan(const struct bitmap *, bool naive, size_t expected);
+
+void test_bitmap_scan(void) {
+    struct bitmap *b;
+    uint64_t naive, word, summary;
+    size_t run;
+
+    random_init(0);
+    check_random(false);
+    check_random(true);
+    msg("Word-at-a-time results match bit-by-bit results.");
+
+    /* Mostly full: one free bit in every 1000, and a single run
+       of RUN_CNT free bits near the end. */
+    b = bitmap_create(BIG_BITS);
+    if (b == NULL)
+        fail("cannot create %d-bit bitmap", BIG_BITS);
+    bitmap_set_all(b, true);
+    for (size_t i = 0; i < BIG_BITS; i += 1000) bitmap_reset(b, i);
+    run = BIG_BITS - 100;
+    bitmap_set_multiple(b, run, RUN_CNT, false);
+
+    naive = time_scan(b, true, run);
+    word = time_scan(b, false, run);
+    if (!bitmap_enable_summary(b))
+        fail("cannot enable bitmap summary");
+    summary = time_scan(b, false, run);
+    bitmap_destroy(b);
+
+    msg("Found the free run in a %d-bit bitmap three ways.", BIG_BITS);
+    printf("bitmap-scan: %llu cycles bit by bit, %llu cycles word at a time, "
+           "%llu cycles with summary\n",
+           naive, word, summary);
+}
+
+/* The bitmap_scan() algorithm before it worked on whole words:
+   tests every starting index, bit by bit. */
+static size_t naive_scan(const struct bitmap *b, size_t start, size_t cnt, bool value) {
+    if (cnt <= bitmap_size(b)) {
+        size_t last = bitmap_size(b) - cnt;
+        for (size_t i = start; i <= last; i++) {
+            size_t j;
+            for (j = 0; j < cnt; j++)
+                if (bitmap_test(b, i + j) != value)
+                    break;
+            if (j == cnt)
+                return i;
+        }
+    }
+    return BITMAP_ERROR;
+}
+
+/* Compares scans and counts on random bitmaps of random sizes
+   and densities, optionally with a summary. */
+static void check_random(bool summary) {
+    for (int round = 0; round < 200; round++) {
+        size_t bit_cnt = random_ulong() % 1000;
+        unsigned density = random_ulong() % 100;
+        struct bitmap *b = bitmap_create(bit_cnt);
+
+        if (b == NULL || (summary && !bitmap_enable_summary(b)))
+            fail("cannot create %zu-bit bitmap", bit_cnt);
+        for (size_t i = 0; i < bit_cnt; i++) bitmap_set(b, i, random_ulong() % 100 < density);
+
+        for (int probe = 0; probe < 20; probe++) {
+            size_t start = random_ulong() % (bit_cnt + 1);
+            size_t cnt = random_ulong() % 12;
+            bool value = random_ulong() % 2;
+            size_t span = random_ulong() % (bit_cnt - start + 1), expected = 0;
+
+            if (bitmap_scan(b, start, cnt, value) != naive_scan(b, start, cnt, value))
+                fail("scan of %zu-bit bitmap from %zu for %zu %s bits differs", bit_cnt, start,
+                     cnt, value ? "true" : "false");
+            for (size_t i = start; i < start + span; i++) expected += bitmap_test(b, i) == value;
+            if (bitmap_count(b, start, span, value) != expected)
+                fail("count of %zu-bit bitmap differs", bit_cnt);
+
+            /* Change a range, to exercise summary updates. */
+            bitmap_set_multiple(b, start, span, !value);
+        }
+        bitmap_destroy(b);
+    }
+}
+
+/* Returns the TSC cycles to find the first RUN_CNT free bits in B
+   with the bit-by-bit scan, if NAIVE, or with bitmap_scan().
+   Fails unless they are found at EXPECTED. */
+static uint64_t time_scan(const struct bitmap *b, bool naive, size_t expected) {
+    uint64_t start = rdtsc();
+    size_t idx = naive ? naive_scan(b, 0, RUN_CNT, false) : bitmap_scan(b, 0, RUN_CNT, false);
+    uint64_t cycles = rdtsc() - start;
+
+    if (idx != expected)
+        fail("found free run at %zu, expected %zu", idx, expected);
+    return cycles;
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The scan cost line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^bitmap-scan: /, @output);
+fail "missing scan cost in output" if @stats != 1;
+fail "malformed scan cost: $stats[0]"
+  unless $stats[0] =~ /^bitmap-scan: \d+ cycles bit by bit, \d+ cycles word at a time, \d+ cycles with summary$/;
+
+common_checks ("run", @output);
+compare_output ("run", [grep (!/^bitmap-scan: /, @output)], [<<'EOF']);
+(bitmap-scan) begin
+(bitmap-scan) Word-at-a-time results match bit-by-bit results.
+(bitmap-scan) Found the free run in a 1048576-bit bitmap three ways.
+(bitmap-scan) end
+EOF
+pass;
@@ -0,0 +1,72 @@
+/* Allocates many blocks a little over 2 kB, which used to take a
+   page each, and checks that they take well under a page each
+   now.  Then shrinks a big block with realloc() and grows it back,
+   checking that both happen in place, that the pages its tail
+   gave back are taken again, and that its contents survive. */
+
+#include <string.h>
+
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+
+#define BLOCK_CNT 64
+#define BLOCK_SIZE 2150
+
+void test_malloc_mid(void) {
+    static char *blocks[BLOCK_CNT];
+    size_t before, used;
+    char *big, *moved;
+    int i;
+
+    before = palloc_free_pages(0);
+    for (i = 0; i < BLOCK_CNT; i++) {
+        blocks[i] = malloc(BLOCK_SIZE);
+        if (blocks[i] == NULL)
+            fail("malloc(%d) failed", BLOCK_SIZE);
+        memset(blocks[i], i, BLOCK_SIZE);
+    }
+    used = before - palloc_free_pages(0);
+    for (i = 0; i < BLOCK_CNT; i++) {
+        for (int j = 0; j < BLOCK_SIZE; j++)
+            if (blocks[i][j] != (char)i)
+                fail("block %d overwritten at byte %d", i, j);
+        free(blocks[i]);
+    }
+    if (used * 8 > BLOCK_CNT * 7)
+        fail("%d blocks of %d bytes took %zu pages", BLOCK_CNT, BLOCK_SIZE, used);
+    msg("%d blocks of %d bytes took under 7/8 page each.", BLOCK_CNT, BLOCK_SIZE);
+
+    /* Shrinking gives back the tail pages, and growing again
+       takes them back, so both must happen in place. */
+    big = malloc(6 * 4096);
+    if (big == NULL)
+        fail("malloc of big block failed");
+    memset(big, 'x', 6 * 4096);
+    before = palloc_free_pages(0);
+    moved = realloc(big, 2 * 4096);
+    if (moved != big)
+        fail("realloc to shrink big block moved it");
+    big = moved;
+    if (palloc_free_pages(0) <= before)
+        fail("shrinking big block gave back no pages");
+    for (i = 0; i < 2 * 4096; i++)
+        if (big[i] != 'x')
+            fail("shrunk block lost byte %d", i);
+    msg("Big block shrank in place and gave back its tail.");
+
+    memset(big, 'y', 2 * 4096);
+    moved = realloc(big, 6 * 4096);
+    if (moved != big)
+        fail("realloc to grow big block moved it");
+    big = moved;
+    if (palloc_free_pages(0) != before)
+        fail("%zu pages free after growing big block back, %zu before shrinking it",
+             palloc_free_pages(0), before);
+    for (i = 0; i < 2 * 4096; i++)
+        if (big[i] != 'y')
+            fail("grown block lost byte %d", i);
+    memset(big, 'z', 6 * 4096);
+    free(big);
+    msg("Big block grew back in place and kept its contents.");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-mid) begin
+(malloc-mid) 64 blocks of 2150 bytes took under 7/8 page each.
+(malloc-mid) Big block shrank in place and gave back its tail.
+(malloc-mid) Big block grew back in place and kept its contents.
+(malloc-mid) end
+EOF
+pass;
@@ -0,0 +1,90 @@
+/* Fills the user pool, then frees an 8-page run out of every 80
+   pages so that the pool is 90% occupied and its free memory is
+   scattered in small holes, and reports the average cost of
+   1-page and 4-page allocations in that state.  Finally checks
+   that freeing everything gives back every page that was free at
+   the start. */
+
+#include <stdio.h>
+
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define ROUNDS 200
+
+/* Allocated pages are chained through their first word. */
+struct chained_page {
+    struct chained_page *next;
+};
+
+static uint64_t get_cycles(size_t page_cnt);
+
+void test_palloc_latency(void) {
+    struct chained_page *all = NULL, *kept = NULL, *p, *next;
+    size_t start_free, total = 0, freed = 0;
+    uint64_t one, four;
+
+    start_free = palloc_free_pages(PAL_USER);
+
+    /* Take every free page in the pool. */
+    while ((p = palloc_get_page(PAL_USER)) != NULL) {
+        p->next = all;
+        all = p;
+        total++;
+    }
+    if (palloc_free_pages(PAL_USER) != 0)
+        fail("pool not empty after allocating %zu pages", total);
+
+    /* Punch 8-page holes at every 80 pages. */
+    for (p = all; p != NULL; p = next) {
+        next = p->next;
+        if (pg_no(p) % 80 < 8) {
+            palloc_free_page(p);
+            freed++;
+        } else {
+            p->next = kept;
+            kept = p;
+        }
+    }
+    msg("Filled the user pool and freed about 10%% of it.");
+    if (total < 80 || freed * 20 < total || freed * 5 > total)
+        fail("freed %zu of %zu pages", freed, total);
+
+    one = get_cycles(1);
+    four = get_cycles(4);
+    printf("palloc-latency: %llu cycles per 1-page get, %llu cycles per 4-page get "
+           "at 90%% occupancy\n",
+           one, four);
+
+    for (p = kept; p != NULL; p = next) {
+        next = p->next;
+        palloc_free_page(p);
+    }
+    if (palloc_free_pages(PAL_USER) != start_free)
+        fail("%zu pages free at end, %zu at start", palloc_free_pages(PAL_USER), start_free);
+    msg("Every page free at the start is free again.");
+    if ((p = palloc_get_multiple(PAL_USER, 2)) == NULL)
+        fail("freed pages were not merged back");
+    palloc_free_multiple(p, 2);
+    msg("Freed pages merged back into larger blocks.");
+}
+
+/* Returns the average TSC cycles to get PAGE_CNT pages from the
+   user pool.  The pages are freed again, untimed, after each
+   round. */
+static uint64_t get_cycles(size_t page_cnt) {
+    uint64_t cycles = 0;
+
+    for (int i = 0; i < ROUNDS; i++) {
+        uint64_t start = rdtsc();
+        void *pages = palloc_get_multiple(PAL_USER, page_cnt);
+
+        cycles += rdtsc() - start;
+        if (pages == NULL)
+            fail("%zu-page allocation failed", page_cnt);
+        palloc_free_multiple(pages, page_cnt);
+    }
+    return cycles / ROUNDS;
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The latency line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^palloc-latency: /, @output);
+fail "missing latency in output" if @stats != 1;
+fail "malformed latency: $stats[0]"
+  unless $stats[0] =~ /^palloc-latency: \d+ cycles per 1-page get, \d+ cycles per 4-page get at 90% occupancy$/;
+
+common_checks ("run", @output);
+compare_output ("run", [grep (!/^palloc-latency: /, @output)], [<<'EOF']);
+(palloc-latency) begin
+(palloc-latency) Filled the user pool and freed about 10% of it.
+(palloc-latency) Every page free at the start is free again.
+(palloc-latency) Freed pages merged back into larger blocks.
+(palloc-latency) end
+EOF
+pass;
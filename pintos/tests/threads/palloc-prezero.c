@@ -0,0 +1,50 @@
+/* Lets the idle thread run, then checks that PAL_ZERO pages
+   come back filled with zeros, even after the same pages were
+   freed dirty and zeroed again in the background, and that the
+   pre-zeroed pages are still counted as free memory. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define PAGE_CNT 16
+#define ROUNDS 4
+
+static void check_zeroed(uint8_t *page, int round);
+
+void test_palloc_prezero(void) {
+    uint8_t *pages[PAGE_CNT];
+    size_t start_free;
+    int round, i;
+
+    start_free = palloc_free_pages(PAL_USER);
+    for (round = 0; round < ROUNDS; round++) {
+        /* Leave the CPU idle, so that pages get zeroed. */
+        timer_sleep(5);
+        for (i = 0; i < PAGE_CNT; i++) {
+            pages[i] = palloc_get_page(PAL_USER | PAL_ZERO);
+            if (pages[i] == NULL)
+                fail("palloc_get_page() failed in round %d", round);
+            check_zeroed(pages[i], round);
+            memset(pages[i], 0x5a, PGSIZE);
+        }
+        for (i = 0; i < PAGE_CNT; i++) palloc_free_page(pages[i]);
+    }
+    msg("PAL_ZERO pages were zeroed in every round.");
+
+    timer_sleep(5);
+    if (palloc_free_pages(PAL_USER) != start_free)
+        fail("%zu pages free at end, %zu at start", palloc_free_pages(PAL_USER), start_free);
+    msg("Pre-zeroed pages are counted as free.");
+}
+
+/* Fails unless PAGE is all zeros. */
+static void check_zeroed(uint8_t *page, int round) {
+    for (size_t ofs = 0; ofs < PGSIZE; ofs++)
+        if (page[ofs] != 0)
+            fail("byte %zu of a PAL_ZERO page is %#x in round %d", ofs, page[ofs], round);
+}
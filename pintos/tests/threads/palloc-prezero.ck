@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-prezero) begin
+(palloc-prezero) PAL_ZERO pages were zeroed in every round.
+(palloc-prezero) Pre-zeroed pages are counted as free.
+(palloc-prezero) end
+EOF
+pass;
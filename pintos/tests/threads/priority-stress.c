@@ -0,0 +1,144 @@
+/* Puts hundreds of ready threads, spread over many priority
+   levels, through the scheduler.  Every thread yields many times,
+   so each yield is a full trip through the run queue.  Checks
+   that no thread runs while a higher priority thread is ready,
+   that threads of one priority take turns, and that no thread
+   finishes before every thread of a higher priority has
+   finished.  Reports how many context switches per second the
+   scheduler sustained, as counted by the scheduler itself. */
+
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 256
+#define LEVEL_CNT 16
+#define ITER_CNT 64
+
+struct stress_data {
+    int *output;            /* Priorities of finished threads, in order. */
+    int *op;                /* Current position in OUTPUT. */
+    int yields[THREAD_CNT]; /* Number of yields done by each thread. */
+    int last_priority;      /* Priority of the thread that ran last. */
+    int inversions;         /* Times a thread ran above LAST_PRIORITY. */
+    int unfair;             /* Threads that finished ahead of their level. */
+};
+
+struct stress_thread_arg {
+    struct stress_data *data;
+    int id; /* Index into DATA->yields. */
+};
+
+static thread_func stress_thread;
+
+void test_priority_stress(void) {
+    static struct stress_thread_arg args[THREAD_CNT];
+    struct stress_data *data;
+    int64_t start, elapsed;
+    long long switches;
+    int i;
+
+    /* This test does not work with the MLFQS. */
+    ASSERT(!thread_mlfqs);
+
+    /* Make sure our priority is the default. */
+    ASSERT(thread_get_priority() == PRI_DEFAULT);
+
+    msg("%d threads at %d priority levels will yield %d times each.", THREAD_CNT, LEVEL_CNT,
+        ITER_CNT);
+
+    data = calloc(1, sizeof *data);
+    ASSERT(data != NULL);
+    data->output = data->op = malloc(sizeof *data->output * THREAD_CNT);
+    ASSERT(data->output != NULL);
+    data->last_priority = PRI_MAX;
+
+    /* Create every thread before any of them runs. */
+    thread_set_priority(PRI_MAX);
+    for (i = 0; i < THREAD_CNT; i++) {
+        char name[16];
+        args[i].data = data;
+        args[i].id = i;
+        snprintf(name, sizeof name, "stress %d", i);
+        if (thread_create(name, PRI_DEFAULT + 1 + i % LEVEL_CNT, stress_thread, &args[i]) ==
+            TID_ERROR)
+            fail("thread_create failed for thread %d", i);
+    }
+
+    /* All the other threads now run to termination here. */
+    switches = thread_switch_count();
+    start = timer_ticks();
+    thread_set_priority(PRI_DEFAULT);
+    elapsed = timer_elapsed(start);
+    switches = thread_switch_count() - switches;
+
+    if (data->op - data->output != THREAD_CNT)
+        fail("only %d of %d threads finished", (int)(data->op - data->output), THREAD_CNT);
+    for (i = 1; i < THREAD_CNT; i++)
+        if (data->output[i] > data->output[i - 1])
+            fail("priority %d thread finished after priority %d thread", data->output[i],
+                 data->output[i - 1]);
+    msg("Threads finished in priority order.");
+
+    /* 높은 우선순위 스레드가 남아 있는 동안 낮은 스레드가 돌면 안 된다. */
+    if (data->inversions != 0)
+        fail("%d times a thread ran while a higher priority thread was ready",
+             data->inversions);
+    msg("No thread ran while a higher priority thread was ready.");
+
+    if (data->unfair != 0)
+        fail("%d threads finished before the rest of their level got half way", data->unfair);
+    msg("Threads of equal priority took turns.");
+
+    /* Every thread shares its level with others until near the end,
+       so most yields must have handed the CPU to a peer. */
+    if (switches < (long long)THREAD_CNT * ITER_CNT / 2)
+        fail("only %lld context switches for %d yields", switches, THREAD_CNT * ITER_CNT);
+    printf("priority-stress: %lld context switches in %lld ticks (%lld switches/s)\n", switches,
+           (long long)elapsed, elapsed > 0 ? switches * TIMER_FREQ / elapsed : 0);
+
+    free(data->output);
+    free(data);
+}
+
+/* Notes, with interrupts off, that the running thread got the CPU,
+   counting it as an inversion if a higher priority thread ran
+   before. */
+static void note_run(struct stress_data *data) {
+    int priority = thread_get_priority();
+
+    if (priority > data->last_priority)
+        data->inversions++;
+    data->last_priority = priority;
+}
+
+static void stress_thread(void *arg_) {
+    struct stress_thread_arg *arg = arg_;
+    struct stress_data *data = arg->data;
+    enum intr_level old_level;
+    int i;
+
+    for (i = 0; i < ITER_CNT; i++) {
+        old_level = intr_disable();
+        note_run(data);
+        data->yields[arg->id]++;
+        intr_set_level(old_level);
+        thread_yield();
+    }
+
+    old_level = intr_disable();
+    note_run(data);
+    /* 라운드 로빈이라면 같은 레벨의 다른 스레드들도 거의 다 돌았어야 한다. */
+    for (i = arg->id % LEVEL_CNT; i < THREAD_CNT; i += LEVEL_CNT)
+        if (data->yields[i] < ITER_CNT / 2) {
+            data->unfair++;
+            break;
+        }
+    *data->op++ = thread_get_priority();
+    intr_set_level(old_level);
+}
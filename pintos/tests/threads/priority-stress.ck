@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# The rate line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^priority-stress: /, @output);
+fail "missing context switch rate in output" if @stats != 1;
+fail "malformed context switch rate: $stats[0]"
+  unless $stats[0] =~ /^priority-stress: \d+ context switches in \d+ ticks \(\d+ switches\/s\)$/;
+
+@output = grep (!/^priority-stress: /, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(priority-stress) begin
+(priority-stress) 256 threads at 16 priority levels will yield 64 times each.
+(priority-stress) Threads finished in priority order.
+(priority-stress) No thread ran while a higher priority thread was ready.
+(priority-stress) Threads of equal priority took turns.
+(priority-stress) end
+EOF
+pass;
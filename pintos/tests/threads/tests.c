@@ -16,6 +16,7 @@ static const struct test tests[] = {
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-many", test_alarm_many},
 
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
@@ -29,6 +30,16 @@ static const struct test tests[] = {
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"priority-stress", test_priority_stress},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
+    {"thread-create", test_thread_create},
+    {"palloc-latency", test_palloc_latency},
+    {"bitmap-scan", test_bitmap_scan},
+    {"malloc-mid", test_malloc_mid},
+    {"palloc-prezero", test_palloc_prezero},
+#ifdef VM
+    {"zswap-roundtrip", test_zswap_roundtrip},
+#endif
 
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
@@ -0,0 +1,56 @@
+/* Creates and exits hundreds of short-lived threads, first with
+   the cache of dead threads' pages disabled and then with it
+   enabled, and reports the average cost of a create/exit pair
+   in each case.  Each thread has a higher priority than the
+   main thread, so it runs and exits before thread_create()
+   returns, which the test checks. */
+
+#include <stdio.h>
+
+#include "intrinsic.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 500
+
+static thread_func exit_thread;
+static uint64_t create_exit_cycles(void);
+
+/* Number of threads that have run exit_thread(). */
+static int ran_cnt;
+
+void test_thread_create(void) {
+    uint64_t uncached, cached;
+
+    /* This test does not work with the MLFQS. */
+    ASSERT(!thread_mlfqs);
+
+    thread_cache_enable(false);
+    uncached = create_exit_cycles();
+    thread_cache_enable(true);
+    cached = create_exit_cycles();
+
+    msg("Created and exited %d threads twice.", THREAD_CNT);
+    msg("Each thread ran before thread_create() returned.");
+    printf("thread-create: %llu cycles per create/exit without thread cache, "
+           "%llu cycles with it\n",
+           uncached, cached);
+}
+
+/* Returns the average TSC cycles to create and run a thread that
+   exits at once. */
+static uint64_t create_exit_cycles(void) {
+    uint64_t start = rdtsc();
+
+    ran_cnt = 0;
+    for (int i = 0; i < THREAD_CNT; i++) {
+        if (thread_create("exit", PRI_DEFAULT + 1, exit_thread, NULL) == TID_ERROR)
+            fail("thread_create failed");
+        if (ran_cnt != i + 1)
+            fail("thread %d had not run when thread_create() returned", i);
+    }
+    return (rdtsc() - start) / THREAD_CNT;
+}
+
+static void exit_thread(void *aux UNUSED) { ran_cnt++; }
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The create/exit cost line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^thread-create: /, @output);
+fail "missing create/exit cost in output" if @stats != 1;
+fail "malformed create/exit cost: $stats[0]"
+  unless $stats[0] =~ /^thread-create: \d+ cycles per create\/exit without thread cache, \d+ cycles with it$/;
+
+common_checks ("run", @output);
+compare_output ("run", [grep (!/^thread-create: /, @output)], [<<'EOF']);
+(thread-create) begin
+(thread-create) Created and exited 500 threads twice.
+(thread-create) Each thread ran before thread_create() returned.
+(thread-create) end
+EOF
+pass;
@@ -0,0 +1,120 @@
+/* Swaps out a page of zeros, a page of text and a page of random
+   bytes through the compressed store, checks that the first two
+   are kept compressed and the third goes to the swap disk, and
+   reads all three back.  Then forces the store to write its pages
+   back to the swap disk and reads them back again from there.
+
+   Needs the VM kernel, so it is only built there. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/anon.h"
+#include "vm/vm.h"
+#include "vm/zswap.h"
+
+enum { ZERO, TEXT, RANDOM, PAGE_CNT };
+
+static const char *names[PAGE_CNT] = {"zero", "text", "random"};
+
+static void fill(int kind, uint8_t *kva);
+static void check_page(int kind, struct page *page, uint8_t *buf, const char *when);
+
+void test_zswap_roundtrip(void) {
+    static struct page pages[PAGE_CNT];
+    static struct frame frames[PAGE_CNT];
+    struct page *cluster[PAGE_CNT];
+    uint8_t *buf = palloc_get_page(PAL_ASSERT);
+    size_t max_pages = zswap_max_pages;
+    int i;
+
+    if (max_pages == 0)
+        fail("zswap is disabled");
+
+    random_init(0x7a5);
+    for (i = 0; i < PAGE_CNT; i++) {
+        frames[i].kva = palloc_get_page(PAL_ASSERT);
+        fill(i, frames[i].kva);
+        pages[i].va = (void *)((uintptr_t)USER_STACK - (i + 1) * PGSIZE);
+        pages[i].owner = thread_current();
+        anon_initializer(&pages[i], VM_ANON, NULL);
+        pages[i].frame = &frames[i];
+        cluster[i] = &pages[i];
+    }
+    if (!anon_swap_out_cluster(cluster, PAGE_CNT))
+        fail("anon_swap_out_cluster() failed");
+
+    for (i = 0; i < PAGE_CNT; i++) {
+        bool compressed = pages[i].anon.zentry != NULL;
+
+        if (compressed != (i != RANDOM))
+            fail("%s page %s compressed", names[i], compressed ? "was" : "was not");
+        if (compressed == (pages[i].anon.swap_slot != SIZE_MAX))
+            fail("%s page is %s on the swap disk", names[i], compressed ? "also" : "not");
+        pages[i].frame = NULL;
+        palloc_free_page(frames[i].kva);
+    }
+    msg("Zero and text pages are compressed; the random page is on disk.");
+
+    for (i = 0; i < PAGE_CNT; i++) check_page(i, &pages[i], buf, "swap-out");
+
+    /* 예산을 0으로 낮춰서 압축된 페이지를 모두 디스크로 내보낸다. */
+    zswap_max_pages = 0;
+    zswap_shrink();
+    zswap_max_pages = max_pages;
+    for (i = 0; i < PAGE_CNT; i++)
+        if (pages[i].anon.zentry != NULL || pages[i].anon.swap_slot == SIZE_MAX)
+            fail("%s page was not written back", names[i]);
+    msg("All pages were written back to the swap disk.");
+
+    for (i = 0; i < PAGE_CNT; i++) check_page(i, &pages[i], buf, "write-back");
+
+    for (i = 0; i < PAGE_CNT; i++) destroy(&pages[i]);
+    palloc_free_page(buf);
+}
+
+/* Fills KVA with the contents of a page of the given KIND.
+   RANDOM pages come from the random number generator, which
+   check_page() reseeds to draw the same bytes again. */
+static void fill(int kind, uint8_t *kva) {
+    static const char text[] =
+        "It was the best of times, it was the worst of times, it was the age of "
+        "wisdom, it was the age of foolishness, it was the epoch of belief.\n";
+    size_t ofs;
+
+    switch (kind) {
+        case ZERO:
+            memset(kva, 0, PGSIZE);
+            break;
+        case TEXT:
+            for (ofs = 0; ofs < PGSIZE; ofs++) kva[ofs] = text[ofs % (sizeof text - 1)];
+            break;
+        case RANDOM:
+            random_bytes(kva, PGSIZE);
+            break;
+    }
+}
+
+/* Reads PAGE, of the given KIND, into BUF and fails unless it has
+   the contents it was swapped out with. */
+static void check_page(int kind, struct page *page, uint8_t *buf, const char *when) {
+    static uint8_t expected[PGSIZE];
+
+    if (kind == ZERO || kind == TEXT)
+        fill(kind, expected);
+    else {
+        /* 같은 씨앗에서 다시 뽑으면 같은 바이트가 나온다. */
+        random_init(0x7a5);
+        fill(RANDOM, expected);
+    }
+
+    anon_read_swap(page, buf);
+    if (memcmp(buf, expected, PGSIZE))
+        fail("%s page read back after %s differs", names[kind], when);
+    msg("%s page read back after %s.", names[kind], when);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(zswap-roundtrip) begin
+(zswap-roundtrip) Zero and text pages are compressed; the random page is on disk.
+(zswap-roundtrip) zero page read back after swap-out.
+(zswap-roundtrip) text page read back after swap-out.
+(zswap-roundtrip) random page read back after swap-out.
+(zswap-roundtrip) All pages were written back to the swap disk.
+(zswap-roundtrip) zero page read back after write-back.
+(zswap-roundtrip) text page read back after write-back.
+(zswap-roundtrip) random page read back after write-back.
+(zswap-roundtrip) end
+EOF
+pass;
@@ -0,0 +1,21 @@
+/* Exercises futex_wait() and futex_wake() within one process.
+   A wait on a word that no longer holds the expected value
+   returns at once, a wake with no waiters wakes no one, and a
+   wait that no one ends times out.
+
+   Processes share memory only through file mappings, which need
+   the VM kernel, so waking a futex from another process is tested
+   by tests/vm/futex-wake and measured by tests/vm/futex-pingpong. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static unsigned word;
+
+void test_main(void) {
+    CHECK(futex_wait(&word, 1, -1) == FUTEX_AGAIN, "futex_wait on a stale value");
+    CHECK(futex_wake(&word, 1) == 0, "futex_wake with no waiters");
+    CHECK(futex_wait(&word, 0, 5) == FUTEX_TIMEDOUT, "futex_wait with a timeout");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) futex_wait on a stale value
+(futex) futex_wake with no waiters
+(futex) futex_wait with a timeout
+(futex) end
+futex: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Child process for text-share test.
+   Runs as "child-text DEPTH PFN": checks that its code is in the
+   physical page PFN, unless PFN is 0, then runs DEPTH more copies of
+   itself, one inside the other, passing on its own code page.  All
+   copies are alive at once.  Exits with 0 if every copy's code was in
+   the same physical page. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+
+int main(int argc UNUSED, char *argv[]) {
+    int depth = atoi(argv[1]);
+    int parent_pfn = atoi(argv[2]);
+    int pfn = (int)((uintptr_t)get_phys_addr((void *)main) >> 12);
+    char cmd[64];
+    pid_t child;
+
+    test_name = "child-text";
+    quiet = true;
+
+    if (pfn == 0 || (parent_pfn != 0 && pfn != parent_pfn))
+        return 1;
+    if (depth == 0)
+        return 0;
+
+    snprintf(cmd, sizeof cmd, "child-text %d %d", depth - 1, pfn);
+    child = fork("child-text");
+    if (child == 0) {
+        exec(cmd);
+        return 2;
+    }
+    return wait(child);
+}
@@ -0,0 +1,69 @@
+/* Fork latency benchmark.  Touches every page of a large heap,
+   then forks and reaps a child over and over.  With copy-on-write
+   fork() shares the heap instead of copying it, so the time per
+   fork should not grow with the heap.  The last child checks that
+   it sees the parent's heap in the parent's frames, then writes
+   to it and checks that it got private copies, and the parent
+   checks that the writes stayed private.  Reports the time per
+   fork. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HEAP_SIZE (4 * 1024 * 1024)
+#define FORKS 16
+
+static char heap[HEAP_SIZE];
+
+/* Run by the last child.  Returns true if the heap holds the
+   parent's bytes in the parent's frame PA, and writing it gives
+   the child a private copy. */
+static bool check_child(void *pa) {
+    size_t i;
+
+    if (get_phys_addr(heap) != pa)
+        return false;
+    for (i = 0; i < HEAP_SIZE / PAGE_SIZE; i++)
+        if (heap[i * PAGE_SIZE] != (char)i)
+            return false;
+    for (i = 0; i < HEAP_SIZE / PAGE_SIZE; i++) heap[i * PAGE_SIZE] = 0;
+    return get_phys_addr(heap) != pa && heap[0] == 0;
+}
+
+void test_main(void) {
+    long long msec;
+    void *pa;
+    size_t i;
+    pid_t child;
+    int n;
+
+    for (i = 0; i < HEAP_SIZE / PAGE_SIZE; i++) heap[i * PAGE_SIZE] = (char)i;
+
+    pa = get_phys_addr(heap);
+    msg("fork");
+    msec = get_vm_stat(VM_STAT_MSEC);
+    for (n = 0; n < FORKS; n++) {
+        child = fork("child");
+        if (child == 0) {
+            exit(n < FORKS - 1 || check_child(pa) ? 0 : 1);
+        }
+        CHECK(child > 0, "fork");
+        if (wait(child) != 0)
+            fail("child %d failed", n);
+    }
+    msec = get_vm_stat(VM_STAT_MSEC) - msec;
+
+    msg("verify");
+    for (i = 0; i < HEAP_SIZE / PAGE_SIZE; i++)
+        if (heap[i * PAGE_SIZE] != (char)i)
+            fail("heap page %zu changed in parent", i);
+    CHECK(get_phys_addr(heap) == pa, "parent kept its frames and bytes");
+
+    printf("cow-fork: %d forks of a %d kB heap in %lld ms, %lld us per fork\n", FORKS,
+           HEAP_SIZE / 1024, msec, msec * 1000 / FORKS);
+}
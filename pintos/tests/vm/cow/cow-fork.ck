@@ -0,0 +1,40 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The fork latency line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^cow-fork: (?!exit\()/, @output);
+fail "missing fork latency in output" if @stats != 1;
+fail "malformed fork latency: $stats[0]"
+  unless $stats[0] =~ /^cow-fork: \d+ forks of a \d+ kB heap in \d+ ms, \d+ us per fork$/;
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, [grep (!/^cow-fork: (?!exit\()/, @output)], [<<'EOF']);
+(cow-fork) begin
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) fork
+(cow-fork) verify
+(cow-fork) parent kept its frames and bytes
+(cow-fork) end
+EOF
+pass;
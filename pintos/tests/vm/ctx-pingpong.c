@@ -0,0 +1,59 @@
+/* Context switch benchmark.  A parent and a child process pass
+   the CPU back and forth with yield(), touching a small working
+   set after every switch, and the parent reports the time per
+   switch.  With PCIDs the switch keeps both processes' TLB
+   entries; boot with -no-pcid to compare with a full flush on
+   every switch.  Each process must still see only its own writes
+   to the working set afterward. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define WORKING_SET 16
+#define ROUNDS 20000
+
+static volatile char pages[WORKING_SET * PAGE_SIZE];
+
+/* Touches every page of the working set, then yields. */
+static void ping(int rounds) {
+    for (int n = 0; n < rounds; n++) {
+        for (int i = 0; i < WORKING_SET; i++) pages[i * PAGE_SIZE]++;
+        yield();
+    }
+}
+
+/* Returns true if every page of the working set was bumped
+   exactly ROUNDS times, plus once before the fork. */
+static bool intact(int rounds) {
+    for (int i = 0; i < WORKING_SET; i++)
+        if (pages[i * PAGE_SIZE] != (char)(rounds + 1))
+            return false;
+    return true;
+}
+
+void test_main(void) {
+    long long msec;
+    pid_t child;
+
+    ping(1);
+    msg("ping-pong");
+    msec = get_vm_stat(VM_STAT_MSEC);
+    child = fork("child");
+    if (child == 0) {
+        ping(ROUNDS);
+        exit(intact(ROUNDS) ? 0 : 1);
+    }
+    CHECK(child > 0, "fork");
+    ping(ROUNDS);
+    if (wait(child) != 0)
+        fail("child's working set was corrupted");
+    msec = get_vm_stat(VM_STAT_MSEC) - msec;
+    CHECK(intact(ROUNDS), "each process kept its own working set");
+
+    printf("ctx-pingpong: %d round trips in %lld ms, %lld ns per switch\n", ROUNDS, msec,
+           msec * 1000000 / (2 * ROUNDS));
+}
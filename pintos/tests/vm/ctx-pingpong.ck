@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The latency line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^ctx-pingpong: (?!exit\()/, @output);
+fail "missing switch latency in output" if @stats != 1;
+fail "malformed switch latency: $stats[0]"
+  unless $stats[0] =~ /^ctx-pingpong: \d+ round trips in \d+ ms, \d+ ns per switch$/;
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, [grep (!/^ctx-pingpong: (?!exit\()/, @output)], [<<'EOF']);
+(ctx-pingpong) begin
+(ctx-pingpong) ping-pong
+(ctx-pingpong) each process kept its own working set
+(ctx-pingpong) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Futex ping-pong benchmark.  A parent and a child process take
+   turns through a word of a file mapping they share: each sleeps
+   in futex_wait() until the word says it is its turn, then hands
+   the turn over and wakes the other with futex_wake().  A second
+   shared word counts the turns, so each player can check that
+   the two strictly alternated.  The parent reports the time per
+   round trip. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SHARED ((unsigned *)0x10000000)
+#define ROUNDS 5000
+
+/* Takes ROUNDS turns as player ME, 0 or 1, through TURN, and
+   counts them in TURN[1].  Returns false if a turn came out of
+   order. */
+static bool play(unsigned *turn, unsigned me, int rounds) {
+    bool ok = true;
+
+    for (int n = 0; n < rounds; n++) {
+        while (*turn != me) futex_wait(turn, !me, -1);
+        if (turn[1] != 2 * n + me)
+            ok = false;
+        turn[1]++;
+        *turn = !me;
+        futex_wake(turn, 1);
+    }
+    return ok;
+}
+
+void test_main(void) {
+    unsigned *turn = SHARED;
+    long long msec;
+    int handle;
+    pid_t child;
+
+    CHECK(create("futex.dat", 4096), "create \"futex.dat\"");
+    CHECK((handle = open("futex.dat")) > 1, "open \"futex.dat\"");
+    CHECK(mmap(SHARED, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"futex.dat\"");
+    turn[0] = turn[1] = 0;
+
+    msg("ping-pong");
+    msec = get_vm_stat(VM_STAT_MSEC);
+    child = fork("child");
+    if (child == 0) {
+        exit(play(turn, 1, ROUNDS) ? 0 : 1);
+    }
+    CHECK(child > 0, "fork");
+    if (!play(turn, 0, ROUNDS))
+        fail("parent took a turn out of order");
+    if (wait(child) != 0)
+        fail("child took a turn out of order");
+    msec = get_vm_stat(VM_STAT_MSEC) - msec;
+    CHECK(turn[1] == 2 * ROUNDS, "%u turns in strict alternation", turn[1]);
+
+    printf("futex-pingpong: %d round trips in %lld ms, %lld ns per round trip\n", ROUNDS, msec,
+           msec * 1000000 / ROUNDS);
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The latency line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^futex-pingpong: (?!exit\()/, @output);
+fail "missing round trip latency in output" if @stats != 1;
+fail "malformed round trip latency: $stats[0]"
+  unless $stats[0] =~ /^futex-pingpong: \d+ round trips in \d+ ms, \d+ ns per round trip$/;
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, [grep (!/^futex-pingpong: (?!exit\()/, @output)], [<<'EOF']);
+(futex-pingpong) begin
+(futex-pingpong) create "futex.dat"
+(futex-pingpong) open "futex.dat"
+(futex-pingpong) mmap "futex.dat"
+(futex-pingpong) ping-pong
+(futex-pingpong) fork
+(futex-pingpong) 10000 turns in strict alternation
+(futex-pingpong) end
+EOF
+pass;
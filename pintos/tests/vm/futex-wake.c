@@ -0,0 +1,40 @@
+/* Maps a file writable, then forks.  The child waits with
+   futex_wait() on a word of the mapping, which it shares with the
+   parent, and the parent wakes it with futex_wake().  The child
+   must come back with FUTEX_WOKEN, and the parent must see what
+   the child wrote to the mapping afterward. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SHARED ((unsigned *)0x10000000)
+
+void test_main(void) {
+    unsigned *word = SHARED, *done = SHARED + 1;
+    int handle, woken = 0;
+    pid_t child;
+
+    CHECK(create("futex.dat", 4096), "create \"futex.dat\"");
+    CHECK((handle = open("futex.dat")) > 1, "open \"futex.dat\"");
+    CHECK(mmap(SHARED, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"futex.dat\"");
+    *word = 0;
+
+    child = fork("child");
+    if (child == 0) {
+        msg("child: wait on the shared word");
+        if (futex_wait(word, 0, 500) != FUTEX_WOKEN)
+            fail("child was not woken");
+        *done = 1;
+        exit(0);
+    }
+
+    /* The child is asleep once a wake finds it. */
+    for (int tries = 0; tries < 1000 && woken == 0; tries++)
+        if ((woken = futex_wake(word, 1)) == 0)
+            yield();
+    CHECK(wait(child) == 0, "wait for child");
+    CHECK(woken == 1, "futex_wake woke the child");
+    CHECK(*done == 1, "child's write is visible to the parent");
+}
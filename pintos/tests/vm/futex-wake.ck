@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-wake) begin
+(futex-wake) create "futex.dat"
+(futex-wake) open "futex.dat"
+(futex-wake) mmap "futex.dat"
+(futex-wake) child: wait on the shared word
+(futex-wake) wait for child
+(futex-wake) futex_wake woke the child
+(futex-wake) child's write is visible to the parent
+(futex-wake) end
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Checks that a very large BSS costs nothing until it is touched:
+   exec() must succeed, untouched pages must not be loaded, and
+   touched pages must read as zeros. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BSS_SIZE (256 * 1024 * 1024)
+
+static char bss[BSS_SIZE];
+
+void test_main(void) {
+    size_t pages[] = {0, BSS_SIZE / PAGE_SIZE / 2, BSS_SIZE / PAGE_SIZE - 1};
+    size_t i;
+
+    for (i = 0; i < sizeof pages / sizeof *pages; i++)
+        CHECK(get_phys_addr(&bss[pages[i] * PAGE_SIZE]) == 0, "check if page is not loaded");
+
+    for (i = 0; i < sizeof pages / sizeof *pages; i++) {
+        char *p = &bss[pages[i] * PAGE_SIZE];
+
+        CHECK(p[0] == 0 && p[PAGE_SIZE - 1] == 0, "check if page is zeroed");
+        p[0] = (char)(i + 1);
+        CHECK(get_phys_addr(p) != 0, "check if page is loaded");
+    }
+
+    for (i = 0; i < sizeof pages / sizeof *pages; i++)
+        CHECK(bss[pages[i] * PAGE_SIZE] == (char)(i + 1), "check memory content");
+    CHECK(get_phys_addr(&bss[PAGE_SIZE]) == 0, "check if page is not loaded");
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lazy-bss) begin
+(lazy-bss) check if page is not loaded
+(lazy-bss) check if page is not loaded
+(lazy-bss) check if page is not loaded
+(lazy-bss) check if page is zeroed
+(lazy-bss) check if page is loaded
+(lazy-bss) check if page is zeroed
+(lazy-bss) check if page is loaded
+(lazy-bss) check if page is zeroed
+(lazy-bss) check if page is loaded
+(lazy-bss) check memory content
+(lazy-bss) check memory content
+(lazy-bss) check memory content
+(lazy-bss) check if page is not loaded
+(lazy-bss) end
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Maps large.txt and reads it sequentially, one byte per page.
+   Mapping the neighbors of each faulting page should take the
+   read far fewer page faults than the file has pages.  Then
+   verifies the mapping against the file's contents. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/large.inc"
+
+#define PAGE_SIZE 4096
+#define ACTUAL ((char *)0x10000000)
+
+void test_main(void) {
+    size_t pages = (sizeof large + PAGE_SIZE - 1) / PAGE_SIZE;
+    long long faults;
+    int handle, sum = 0;
+    size_t i;
+
+    CHECK((handle = open("large.txt")) > 1, "open \"large.txt\"");
+    CHECK(mmap(ACTUAL, sizeof large, 0, handle, 0) != MAP_FAILED, "mmap \"large.txt\"");
+
+    faults = get_vm_stat(VM_STAT_FAULTS);
+    for (i = 0; i < pages; i++) sum += ACTUAL[i * PAGE_SIZE];
+    faults = get_vm_stat(VM_STAT_FAULTS) - faults;
+
+    CHECK(faults * 4 <= (long long)pages, "read faults on at most a quarter of the pages");
+    CHECK(!memcmp(ACTUAL, large, sizeof large), "mapping matches \"large.txt\"");
+    printf("mmap-around: %zu pages in %lld faults (sum %d)\n", pages, faults, sum);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The fault count line carries measured numbers; check its shape
+# and compare everything else exactly.
+my (@stats) = grep (/^mmap-around: (?!exit\()/, @output);
+fail "missing fault count in output" if @stats != 1;
+fail "malformed fault count: $stats[0]"
+  unless $stats[0] =~ /^mmap-around: \d+ pages in \d+ faults \(sum -?\d+\)$/;
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, [grep (!/^mmap-around: (?!exit\()/, @output)], [<<'EOF']);
+(mmap-around) begin
+(mmap-around) open "large.txt"
+(mmap-around) mmap "large.txt"
+(mmap-around) read faults on at most a quarter of the pages
+(mmap-around) mapping matches "large.txt"
+(mmap-around) end
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Maps sample.txt read-only, then has a child process map it
+   again at another address.  Both mappings of the page should
+   use the same frame. */
+
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/sample.inc"
+
+#define FIRST ((char *)0x10000000)
+#define SECOND ((char *)0x20000000)
+
+void test_main(void) {
+    int handle;
+    void *pa;
+    pid_t child;
+
+    CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+    CHECK(mmap(FIRST, 4096, 0, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+    CHECK(!memcmp(FIRST, sample, strlen(sample)), "read mapping");
+    pa = get_phys_addr(FIRST);
+
+    child = fork("child");
+    if (child == 0) {
+        munmap(FIRST);
+        CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\" again");
+        CHECK(mmap(SECOND, 4096, 0, handle, 0) != MAP_FAILED, "mmap it at another address");
+        CHECK(!memcmp(SECOND, sample, strlen(sample)), "read second mapping");
+        CHECK(get_phys_addr(SECOND) == pa, "both mappings use the same frame");
+        exit(0);
+    }
+    CHECK(wait(child) == 0, "wait for child");
+    CHECK(!memcmp(FIRST, sample, strlen(sample)), "read mapping again");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-share) begin
+(mmap-share) open "sample.txt"
+(mmap-share) mmap "sample.txt"
+(mmap-share) read mapping
+(mmap-share) open "sample.txt" again
+(mmap-share) mmap it at another address
+(mmap-share) read second mapping
+(mmap-share) both mappings use the same frame
+(mmap-share) wait for child
+(mmap-share) read mapping again
+(mmap-share) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Page replacement benchmark.  Sweeps a large array several
+   times while repeatedly touching a small "hot" array, so that a
+   good replacement policy keeps the hot pages resident and evicts
+   the sweep's pages instead.  Verifies both arrays and that pages
+   were evicted, then reports page faults and evictions per
+   second. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define COLD_SIZE (8 * 1024 * 1024)
+#define HOT_SIZE (512 * 1024)
+#define PASSES 3
+
+static char cold[COLD_SIZE];
+static char hot[HOT_SIZE];
+
+void test_main(void) {
+    long long faults, evictions, msec;
+    size_t i, j;
+    int pass;
+
+    faults = get_vm_stat(VM_STAT_FAULTS);
+    evictions = get_vm_stat(VM_STAT_EVICTIONS);
+    msec = get_vm_stat(VM_STAT_MSEC);
+
+    msg("sweep");
+    for (pass = 0; pass < PASSES; pass++)
+        for (i = 0; i < COLD_SIZE / PAGE_SIZE; i++) {
+            cold[i * PAGE_SIZE] = (char)(i + pass);
+            if (i % 16 == 0)
+                for (j = 0; j < HOT_SIZE / PAGE_SIZE; j++) hot[j * PAGE_SIZE]++;
+        }
+
+    msg("verify");
+    for (i = 0; i < COLD_SIZE / PAGE_SIZE; i++)
+        if (cold[i * PAGE_SIZE] != (char)(i + PASSES - 1))
+            fail("cold page %zu is inconsistent", i);
+    for (j = 0; j < HOT_SIZE / PAGE_SIZE; j++)
+        if (hot[j * PAGE_SIZE] != (char)(PASSES * (COLD_SIZE / PAGE_SIZE / 16)))
+            fail("hot page %zu is inconsistent", j);
+    msg("every page holds its last value");
+
+    faults = get_vm_stat(VM_STAT_FAULTS) - faults;
+    evictions = get_vm_stat(VM_STAT_EVICTIONS) - evictions;
+    msec = get_vm_stat(VM_STAT_MSEC) - msec;
+    CHECK(evictions > 0, "the sweep evicted pages");
+    if (msec == 0)
+        msec = 1;
+    printf("page-clock: %lld faults, %lld evictions in %lld ms, "
+           "%lld faults/s, %lld evictions/s\n",
+           faults, evictions, msec, faults * 1000 / msec, evictions * 1000 / msec);
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+# The rate line carries measured numbers; check its shape and
+# compare everything else exactly.
+my (@stats) = grep (/^page-clock: (?!exit\()/, @output);
+fail "missing fault and eviction rates in output" if @stats != 1;
+fail "malformed fault and eviction rates: $stats[0]"
+  unless $stats[0] =~ /^page-clock: \d+ faults, \d+ evictions in \d+ ms, \d+ faults\/s, \d+ evictions\/s$/;
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, [grep (!/^page-clock: (?!exit\()/, @output)], [<<'EOF']);
+(page-clock) begin
+(page-clock) sweep
+(page-clock) verify
+(page-clock) every page holds its last value
+(page-clock) the sweep evicted pages
+(page-clock) end
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Touches the bottom of a large stack object first, so that the
+   stack grows by many pages in a single fault, then checks that the
+   pages above it were prefaulted, that every page reads as zeros,
+   and that the stack high-water mark covers the object. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define STACK_OBJ_SIZE (256 * 1024)
+
+void test_main(void) {
+    volatile char buf[STACK_OBJ_SIZE];
+    long long faults;
+    size_t i;
+
+    faults = get_vm_stat(VM_STAT_FAULTS);
+    buf[0] = 1;
+    CHECK(get_vm_stat(VM_STAT_FAULTS) - faults <= 2, "grow stack in one fault");
+    CHECK(get_phys_addr((void *)&buf[PAGE_SIZE]) != 0, "check if page above is loaded");
+    CHECK(get_vm_stat(VM_STAT_STACK) >= STACK_OBJ_SIZE, "check stack high-water mark");
+
+    for (i = PAGE_SIZE; i < STACK_OBJ_SIZE; i += PAGE_SIZE)
+        if (buf[i] != 0)
+            fail("page at offset %zu is not zeroed", i);
+    msg("check if pages are zeroed");
+}
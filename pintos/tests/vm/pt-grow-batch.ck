@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pt-grow-batch) begin
+(pt-grow-batch) grow stack in one fault
+(pt-grow-batch) check if page above is loaded
+(pt-grow-batch) check stack high-water mark
+(pt-grow-batch) check if pages are zeroed
+(pt-grow-batch) end
+EOF
+pass;
@@ -0,0 +1,17 @@
+/* Runs eight copies of child-text at once and checks that they all
+   execute the same physical copy of its code. */
+
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+    pid_t child = fork("child-text");
+
+    if (child == 0) {
+        exec("child-text 7 0");
+        fail("exec \"child-text\"");
+    }
+    CHECK(wait(child) == 0, "8 processes share the code of child-text");
+}
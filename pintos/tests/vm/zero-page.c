@@ -0,0 +1,36 @@
+/* Reads every page of a 16 MB BSS, which must all be backed by one
+   shared page of zeros, then checks that writing to one of them
+   gives it a page of its own without disturbing the others. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BSS_SIZE (16 * 1024 * 1024)
+
+static char bss[BSS_SIZE];
+
+void test_main(void) {
+    void *zero;
+    size_t i;
+
+    for (i = 0; i < BSS_SIZE; i += PAGE_SIZE)
+        if (bss[i] != 0)
+            fail("byte %zu is not zero", i);
+    msg("read every page");
+
+    zero = get_phys_addr(&bss[0]);
+    CHECK(zero != NULL && get_phys_addr(&bss[BSS_SIZE / 2]) == zero &&
+              get_phys_addr(&bss[BSS_SIZE - PAGE_SIZE]) == zero,
+          "check if pages share the zero page");
+
+    bss[PAGE_SIZE] = 1;
+    CHECK(get_phys_addr(&bss[PAGE_SIZE]) != zero, "check if written page is private");
+    CHECK(bss[PAGE_SIZE] == 1 && bss[0] == 0 && bss[2 * PAGE_SIZE] == 0,
+          "check memory content");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-page) begin
+(zero-page) read every page
+(zero-page) check if pages share the zero page
+(zero-page) check if written page is private
+(zero-page) check memory content
+(zero-page) end
+EOF
+pass;
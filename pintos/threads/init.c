@@ -15,6 +15,7 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -22,7 +23,9 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
@@ -33,6 +36,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -43,6 +47,9 @@
 /* Page-map-level-4 with kernel mappings only. */
 uint64_t *base_pml4;
 
+/* CR0 bit that makes ring 0 honor read-only PTEs. */
+#define CR0_WP (1 << 16)
+
 #ifdef FILESYS
 /* -f: Format the file system? */
 static bool format_filesys;
@@ -85,7 +92,9 @@ int main (void) {
     /* Initialize memory system. */
     mem_end = palloc_init ();
     malloc_init ();
+    kmem_init ();
     paging_init (mem_end);
+    pcid_init ();
 
 #ifdef USERPROG
     tss_init ();
@@ -100,11 +109,15 @@ int main (void) {
 #ifdef USERPROG
     exception_init ();
     syscall_init ();
+#ifndef VM
+    process_cow_init ();
+#endif
 #endif
     /* Start thread scheduler and enable interrupts. */
     thread_start ();
     serial_init_queue ();
     timer_calibrate ();
+    trace_init ();
 
 #ifdef FILESYS
     /* Initialize file system. */
@@ -163,6 +176,12 @@ static void paging_init (uint64_t mem_end) {
 
     // reload cr3
     pml4_activate (0);
+
+    /* Make ring 0 honor read-only PTEs as well.  Otherwise a system
+       call that writes to a user page fork() left shared
+       copy-on-write, or to any other read-only user page, would
+       write straight through instead of faulting. */
+    lcr0 (rcr0 () | CR0_WP);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -217,11 +236,25 @@ static char **parse_options (char **argv) {
             random_init (atoi (value));
         else if (!strcmp (name, "-mlfqs"))
             thread_mlfqs = true;
+        else if (!strcmp (name, "-lockstat"))
+            lock_profiling = true;
+        else if (!strcmp (name, "-tickless"))
+            timer_tickless = true;
+        else if (!strcmp (name, "-trace"))
+            trace_enabled = true;
+        else if (!strcmp (name, "-no-pcid"))
+            pcid_enabled = false;
 #ifdef USERPROG
         else if (!strcmp (name, "-ul"))
             user_page_limit = atoi (value);
         else if (!strcmp (name, "-threads-tests"))
             thread_tests = true;
+#endif
+#ifdef VM
+        else if (!strcmp (name, "-zswap"))
+            zswap_max_pages = atoi (value);
+        else if (!strcmp (name, "-stack"))
+            vm_stack_max = (size_t) atoi (value) * 1024;
 #endif
         else
             PANIC ("unknown option `%s' (use -h for help)", name);
@@ -316,8 +349,16 @@ static void usage (void) {
         "  -f                 Format file system disk during startup.\n"
         "  -rs=SEED           Set random number seed to SEED.\n"
         "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+        "  -tickless          Stop the periodic timer tick while idle.\n"
+        "  -lockstat          Print lock contention statistics at power off.\n"
+        "  -trace             Trace scheduler events and dump them at power off.\n"
+        "  -no-pcid           Flush the TLB on every address space switch.\n"
 #ifdef USERPROG
         "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+        "  -zswap=COUNT       Keep up to COUNT pages of compressed swap in RAM.\n"
+        "  -stack=KB          Let user stacks grow up to KB kB (default 1024).\n"
 #endif
     );
     power_off ();
@@ -342,6 +383,15 @@ void power_off (void) {
 static void print_stats (void) {
     timer_print_stats ();
     thread_print_stats ();
+    palloc_print_stats ();
+    malloc_print_stats ();
+    kmem_print_stats ();
+    pcid_print_stats ();
+#ifdef VM
+    vm_print_stats ();
+#endif
+    timer_print_tickless_stats ();
+    lock_print_stats ();
 #ifdef FILESYS
     disk_print_stats ();
 #endif
@@ -350,4 +400,5 @@ static void print_stats (void) {
 #ifdef USERPROG
     exception_print_stats ();
 #endif
+    trace_dump ();
 }
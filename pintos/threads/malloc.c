@@ -30,20 +30,41 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   Blocks of up to 1 kB come from single-page arenas.  Larger
+   power-of-2 sizes would waste most of a page, so above 1 kB
+   there are instead a few intermediate sizes (MID_SIZES), whose
+   arenas span up to MID_ARENA_PAGES contiguous pages, chosen to
+   waste the least space.  A block in such an arena may begin in
+   any of its pages, so each page of a multi-page arena records
+   the arena as its owner with palloc_set_owner(), and
+   block_to_arena() looks the owner up.
+
+   We can't handle blocks bigger than the largest intermediate
+   size using this scheme.  We handle those by allocating
+   contiguous pages with the page allocator and sticking the
+   allocation size at the beginning of the allocated block's
+   arena header.  realloc() grows such a "big block" in place if
+   the pages after it are free. */
 
 /* Descriptor. */
 struct desc {
     size_t block_size;       /* Size of each element in bytes. */
     size_t blocks_per_arena; /* Number of blocks in an arena. */
+    size_t arena_pages;      /* Number of pages in an arena. */
     struct list free_list;   /* List of free blocks. */
     struct lock lock;        /* Lock. */
+    char name[16];           /* Name of `lock', e.g. "malloc 16". */
+
+    /* Statistics, protected by `lock'. */
+    size_t in_use;    /* Blocks allocated. */
+    size_t peak;      /* Maximum of `in_use'. */
+    size_t arena_cnt; /* Arenas allocated. */
 };
 
+/* Intermediate block sizes, and the largest arena they use. */
+static const size_t MID_SIZES[] = {1536, 2048, 3072, 6144};
+#define MID_ARENA_PAGES 8
+
 /* Magic number for detecting arena corruption. */
 #define ARENA_MAGIC 0x9a548eed
 
@@ -60,24 +81,71 @@ struct block {
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10]; /* Descriptors. */
+static struct desc descs[16]; /* Descriptors. */
 static size_t desc_cnt;       /* Number of descriptors. */
 
+/* Big block statistics, protected by `big_lock'. */
+static struct lock big_lock;
+static size_t big_in_use, big_peak, big_pages;
+
 static struct arena *block_to_arena(struct block *);
 static struct block *arena_to_block(struct arena *, size_t idx);
+static void big_account(int block_delta, ptrdiff_t page_delta);
+
+/* Initializes descriptor D for BLOCK_SIZE-byte blocks in
+   ARENA_PAGES-page arenas. */
+static void desc_init(struct desc *d, size_t block_size, size_t arena_pages) {
+    d->block_size = block_size;
+    d->arena_pages = arena_pages;
+    d->blocks_per_arena = (arena_pages * PGSIZE - sizeof(struct arena)) / block_size;
+    list_init(&d->free_list);
+    snprintf(d->name, sizeof d->name, "malloc %zu", block_size);
+    lock_init_named(&d->lock, d->name);
+    d->in_use = d->peak = d->arena_cnt = 0;
+}
 
 /* Initializes the malloc() descriptors. */
 void malloc_init(void) {
-    size_t block_size;
+    size_t block_size, i;
 
     for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-        struct desc *d = &descs[desc_cnt++];
-        ASSERT(desc_cnt <= sizeof descs / sizeof *descs);
-        d->block_size = block_size;
-        d->blocks_per_arena = (PGSIZE - sizeof(struct arena)) / block_size;
-        list_init(&d->free_list);
-        lock_init(&d->lock);
+        ASSERT(desc_cnt < sizeof descs / sizeof *descs);
+        desc_init(&descs[desc_cnt++], block_size, 1);
+    }
+
+    /* Give each intermediate size the arena size, up to
+       MID_ARENA_PAGES pages, that wastes the smallest fraction of
+       the arena. */
+    for (i = 0; i < sizeof MID_SIZES / sizeof *MID_SIZES; i++) {
+        size_t best_pages = 0, best_waste = 0, pages;
+
+        for (pages = 1; pages <= MID_ARENA_PAGES; pages++) {
+            size_t usable = pages * PGSIZE - sizeof(struct arena);
+            size_t waste = usable % MID_SIZES[i] + sizeof(struct arena);
+
+            if (usable >= MID_SIZES[i] &&
+                (best_pages == 0 || waste * best_pages < best_waste * pages)) {
+                best_pages = pages;
+                best_waste = waste;
+            }
+        }
+        ASSERT(desc_cnt < sizeof descs / sizeof *descs);
+        desc_init(&descs[desc_cnt++], MID_SIZES[i], best_pages);
     }
+    lock_init_named(&big_lock, "malloc big");
+}
+
+/* Prints per-descriptor statistics for descriptors that have
+   been used, and big block statistics. */
+void malloc_print_stats(void) {
+    struct desc *d;
+
+    for (d = descs; d < descs + desc_cnt; d++)
+        if (d->peak > 0)
+            printf("%s: %zu in use, %zu peak, %zu arenas of %zu page(s)\n", d->name, d->in_use,
+                   d->peak, d->arena_cnt, d->arena_pages);
+    if (big_peak > 0)
+        printf("malloc big: %zu in use, %zu peak, %zu pages\n", big_in_use, big_peak, big_pages);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -109,6 +177,8 @@ void *malloc(size_t size) {
         a->magic = ARENA_MAGIC;
         a->desc = NULL;
         a->free_cnt = page_cnt;
+        palloc_set_owner(a, 1, a);
+        big_account(1, page_cnt);
         return a + 1;
     }
 
@@ -118,8 +188,8 @@ void *malloc(size_t size) {
     if (list_empty(&d->free_list)) {
         size_t i;
 
-        /* Allocate a page. */
-        a = palloc_get_page(0);
+        /* Allocate the arena's pages. */
+        a = palloc_get_multiple(0, d->arena_pages);
         if (a == NULL) {
             lock_release(&d->lock);
             return NULL;
@@ -129,6 +199,8 @@ void *malloc(size_t size) {
         a->magic = ARENA_MAGIC;
         a->desc = d;
         a->free_cnt = d->blocks_per_arena;
+        palloc_set_owner(a, d->arena_pages, a);
+        d->arena_cnt++;
         for (i = 0; i < d->blocks_per_arena; i++) {
             struct block *b = arena_to_block(a, i);
             list_push_back(&d->free_list, &b->free_elem);
@@ -139,6 +211,8 @@ void *malloc(size_t size) {
     b = list_entry(list_pop_front(&d->free_list), struct block, free_elem);
     a = block_to_arena(b);
     a->free_cnt--;
+    if (++d->in_use > d->peak)
+        d->peak = d->in_use;
     lock_release(&d->lock);
     return b;
 }
@@ -171,6 +245,33 @@ static size_t block_size(void *block) {
     return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs(block);
 }
 
+/* Tries to resize OLD_BLOCK to NEW_SIZE bytes without moving it.
+   Returns true if successful, false otherwise. */
+static bool resize_in_place(void *old_block, size_t new_size) {
+    struct arena *a = block_to_arena(old_block);
+    size_t page_cnt;
+
+    /* A block in an arena can only be resized within its size. */
+    if (a->desc != NULL)
+        return new_size <= a->desc->block_size;
+
+    /* A big block that would fit in a descriptor's block had
+       better move there, to give back its pages. */
+    if (new_size <= descs[desc_cnt - 1].block_size)
+        return false;
+
+    /* Shrink a big block by freeing its tail, or grow it by
+       taking the pages that follow it. */
+    page_cnt = DIV_ROUND_UP(new_size + sizeof *a, PGSIZE);
+    if (page_cnt < a->free_cnt)
+        palloc_free_multiple((uint8_t *)a + page_cnt * PGSIZE, a->free_cnt - page_cnt);
+    else if (!palloc_grow(a, a->free_cnt, page_cnt))
+        return false;
+    big_account(0, (ptrdiff_t)page_cnt - (ptrdiff_t)a->free_cnt);
+    a->free_cnt = page_cnt;
+    return true;
+}
+
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
    moving it in the process.
    If successful, returns the new block; on failure, returns a
@@ -181,6 +282,8 @@ void *realloc(void *old_block, size_t new_size) {
     if (new_size == 0) {
         free(old_block);
         return NULL;
+    } else if (old_block != NULL && resize_in_place(old_block, new_size)) {
+        return old_block;
     } else {
         void *new_block = malloc(new_size);
         if (old_block != NULL && new_block != NULL) {
@@ -213,6 +316,7 @@ void free(void *p) {
 
             /* Add block to free list. */
             list_push_front(&d->free_list, &b->free_elem);
+            d->in_use--;
 
             /* If the arena is now entirely unused, free it. */
             if (++a->free_cnt >= d->blocks_per_arena) {
@@ -223,12 +327,14 @@ void free(void *p) {
                     struct block *b = arena_to_block(a, i);
                     list_remove(&b->free_elem);
                 }
-                palloc_free_page(a);
+                palloc_free_multiple(a, d->arena_pages);
+                d->arena_cnt--;
             }
 
             lock_release(&d->lock);
         } else {
             /* It's a big block.  Free its pages. */
+            big_account(-1, -(ptrdiff_t)a->free_cnt);
             palloc_free_multiple(a, a->free_cnt);
             return;
         }
@@ -237,19 +343,31 @@ void free(void *p) {
 
 /* Returns the arena that block B is inside. */
 static struct arena *block_to_arena(struct block *b) {
-    struct arena *a = pg_round_down(b);
+    struct arena *a = palloc_get_owner(pg_round_down(b));
 
     /* Check that the arena is valid. */
     ASSERT(a != NULL);
     ASSERT(a->magic == ARENA_MAGIC);
 
     /* Check that the block is properly aligned for the arena. */
-    ASSERT(a->desc == NULL || (pg_ofs(b) - sizeof *a) % a->desc->block_size == 0);
+    ASSERT(a->desc == NULL ||
+           ((uint8_t *)b - (uint8_t *)a - sizeof *a) % a->desc->block_size == 0);
     ASSERT(a->desc != NULL || pg_ofs(b) == sizeof *a);
 
     return a;
 }
 
+/* Adds BLOCK_DELTA to the number of big blocks in use and
+   PAGE_DELTA to the number of pages they occupy. */
+static void big_account(int block_delta, ptrdiff_t page_delta) {
+    lock_acquire(&big_lock);
+    big_in_use += block_delta;
+    big_pages += page_delta;
+    if (big_in_use > big_peak)
+        big_peak = big_in_use;
+    lock_release(&big_lock);
+}
+
 /* Returns the (IDX - 1)'th block within arena A. */
 static struct block *arena_to_block(struct arena *a, size_t idx) {
     ASSERT(a != NULL);
@@ -2,14 +2,154 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "intrinsic.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
 
+/* Process-context identifiers.  With CR4.PCIDE set, the CPU tags
+ * TLB entries with the PCID in the low 12 bits of CR3, and a CR3
+ * load with bit 63 set keeps the entries of the PCID it loads, so a
+ * switch between address spaces need not flush the TLB.  See
+ * [IA32-v3a] 4.10.1 "Process-Context Identifiers (PCIDs)".
+ *
+ * PCID 0 belongs to base_pml4.  User page tables borrow the other
+ * PCID_CNT - 1 IDs, which a clock hand hands out again in turn when
+ * they run out.  A PCID may still tag entries of the pml4 that had
+ * it before, so the first load of a PCID by its new owner flushes
+ * it.  The same goes for the first load after a mapping of a pml4
+ * that was not active was removed or write-protected, since
+ * invlpg only reaches the active PCID. */
+#define PCID_CNT 32
+#define CR3_NOFLUSH (1ULL << 63)
+#define CR4_PCIDE (1 << 17)
+#define CPUID_1_ECX_PCID (1 << 17)
+
+/* Use PCIDs if the CPU has them.  Cleared by -no-pcid. */
+bool pcid_enabled = true;
+
+/* True once pcid_init() set CR4.PCIDE. */
+static bool pcid_on;
+
+struct pcid_slot {
+    uint64_t *pml4; /* Owner, or NULL. */
+    bool stale;     /* Must flush on the next load. */
+};
+static struct pcid_slot pcid_slots[PCID_CNT];
+static unsigned pcid_hand = 1;
+
+/* Statistics. */
+static long long cr3_load_cnt;   /* CR3 loads. */
+static long long cr3_keep_cnt;   /* Of those, loads that kept the TLB. */
+static long long pcid_steal_cnt; /* PCIDs taken from another pml4. */
+
+/* Turns on PCIDs if pcid_enabled is set and the CPU supports them.
+ * Called once paging_init() loaded base_pml4 with PCID 0. */
+void pcid_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (pcid_enabled && (ecx & CPUID_1_ECX_PCID) == 0) {
+        printf("PCID: not supported by this CPU, flushing the TLB on every switch\n");
+        pcid_enabled = false;
+    }
+    if (!pcid_enabled)
+        return;
+
+    pcid_slots[0].pml4 = base_pml4;
+    lcr4(rcr4() | CR4_PCIDE);
+    pcid_on = true;
+    printf("PCID: %d address space IDs\n", PCID_CNT);
+}
+
+/* Returns true if PML4 is the active page table. */
+static bool pml4_is_active(uint64_t *pml4) {
+    return (rcr3() & ~(uint64_t)PGMASK) == vtop(pml4);
+}
+
+/* Returns PML4's PCID, or 0 if it has none.  Call with interrupts
+ * off. */
+static unsigned pcid_find(uint64_t *pml4) {
+    for (unsigned i = 1; i < PCID_CNT; i++)
+        if (pcid_slots[i].pml4 == pml4)
+            return i;
+    return 0;
+}
+
+/* Makes the next load of PML4 flush its PCID, because one of its
+ * mappings was removed or write-protected while it was not active. */
+static void pcid_invalidate(uint64_t *pml4) {
+    enum intr_level old_level;
+    unsigned pcid;
+
+    if (!pcid_on)
+        return;
+    old_level = intr_disable();
+    pcid = pcid_find(pml4);
+    if (pcid != 0)
+        pcid_slots[pcid].stale = true;
+    intr_set_level(old_level);
+}
+
+/* Drops PML4's TLB entry for VPAGE: right away if PML4 is active,
+ * otherwise before PML4 runs again.  Without PCIDs the switch to
+ * PML4 flushes the TLB anyway. */
+static void pml4_invalidate_page(uint64_t *pml4, const void *vpage) {
+    if (pml4_is_active(pml4))
+        invlpg((uint64_t)vpage);
+    else
+        pcid_invalidate(pml4);
+}
+
+/* Returns the CR3 value that activates PML4: its address and, with
+ * PCIDs, its PCID, plus CR3_NOFLUSH if the TLB entries it has are
+ * still good.  Gives PML4 a PCID if it has none.  Call with
+ * interrupts off. */
+static uint64_t pcid_cr3(uint64_t *pml4) {
+    unsigned pcid;
+
+    if (!pcid_on)
+        return vtop(pml4);
+    if (pml4 == base_pml4)
+        return vtop(pml4) | CR3_NOFLUSH;
+
+    pcid = pcid_find(pml4);
+    if (pcid == 0) {
+        pcid = pcid_hand;
+        pcid_hand = pcid_hand + 1 < PCID_CNT ? pcid_hand + 1 : 1;
+        if (pcid_slots[pcid].pml4 != NULL)
+            pcid_steal_cnt++;
+        pcid_slots[pcid] = (struct pcid_slot){.pml4 = pml4, .stale = true};
+    }
+    if (pcid_slots[pcid].stale) {
+        pcid_slots[pcid].stale = false;
+        return vtop(pml4) | pcid;
+    }
+    cr3_keep_cnt++;
+    return vtop(pml4) | pcid | CR3_NOFLUSH;
+}
+
+/* Drops every TLB entry of PML4's user mappings, now if PML4 is
+ * active, otherwise before it runs again.  For callers that edit
+ * PML4's PTEs themselves. */
+void pml4_flush(uint64_t *pml4) {
+    if (pml4_is_active(pml4))
+        lcr3(rcr3());
+    else
+        pcid_invalidate(pml4);
+}
+
+/* Prints CR3 load statistics. */
+void pcid_print_stats(void) {
+    printf("TLB: %lld address space switches, %lld kept the TLB, %lld PCIDs recycled\n",
+           cr3_load_cnt, cr3_keep_cnt, pcid_steal_cnt);
+}
+
 static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create) {
     int idx = PDX(va);
     if (pdp) {
@@ -178,6 +318,16 @@ void pml4_destroy(uint64_t *pml4) {
         return;
     ASSERT(pml4 != base_pml4);
 
+    /* 같은 페이지가 다음 pml4로 다시 쓰여도 옛 PCID를 물려받지 않게 한다. */
+    if (pcid_on) {
+        enum intr_level old_level = intr_disable();
+        unsigned pcid = pcid_find(pml4);
+
+        if (pcid != 0)
+            pcid_slots[pcid].pml4 = NULL;
+        intr_set_level(old_level);
+    }
+
     /* if PML4 (vaddr) >= 1, it's kernel space by define. */
     uint64_t *pdpe = ptov((uint64_t *)pml4[0]);
     if (((uint64_t)pdpe) & PTE_P)
@@ -188,7 +338,11 @@ void pml4_destroy(uint64_t *pml4) {
 /* Loads page directory PD into the CPU's page directory base
  * register. */
 void pml4_activate(uint64_t *pml4) {
-    lcr3(vtop(pml4 ? pml4 : base_pml4));
+    enum intr_level old_level = intr_disable();
+
+    lcr3(pcid_cr3(pml4 ? pml4 : base_pml4));
+    cr3_load_cnt++;
+    intr_set_level(old_level);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -221,8 +375,13 @@ bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw) {
 
     uint64_t *pte = pml4e_walk(pml4, (uint64_t)upage, 1);
 
-    if (pte)
+    if (pte) {
+        uint64_t old = *pte;
+
         *pte = vtop(kpage) | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+        if (old & PTE_P)
+            pml4_invalidate_page(pml4, upage);
+    }
     return pte != NULL;
 }
 
@@ -239,8 +398,7 @@ void pml4_clear_page(uint64_t *pml4, void *upage) {
 
     if (pte != NULL && (*pte & PTE_P) != 0) {
         *pte &= ~PTE_P;
-        if (rcr3() == vtop(pml4))
-            invlpg((uint64_t)upage);
+        pml4_invalidate_page(pml4, upage);
     }
 }
 
@@ -263,8 +421,8 @@ void pml4_set_dirty(uint64_t *pml4, const void *vpage, bool dirty) {
         else
             *pte &= ~(uint32_t)PTE_D;
 
-        if (rcr3() == vtop(pml4))
-            invlpg((uint64_t)vpage);
+        /* TLB에 D가 남아 있으면 다음 쓰기가 PTE에 D를 다시 켜지 않는다. */
+        pml4_invalidate_page(pml4, vpage);
     }
 }
 
@@ -282,12 +440,32 @@ bool pml4_is_accessed(uint64_t *pml4, const void *vpage) {
 void pml4_set_accessed(uint64_t *pml4, const void *vpage, bool accessed) {
     uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
     if (pte) {
+        bool was_accessed = (*pte & PTE_A) != 0;
+
         if (accessed)
             *pte |= PTE_A;
         else
             *pte &= ~(uint32_t)PTE_A;
 
-        if (rcr3() == vtop(pml4))
-            invlpg((uint64_t)vpage);
+        /* TLB에 항목이 남아 있으면 CPU가 A를 다시 켜지 않아, 자주 쓰는 페이지가
+         * clock에는 안 쓰인 것처럼 보인다.  비활성 pml4면 PCID를 비운다.
+         * A가 꺼져 있던 페이지는 그 뒤로 TLB에 올라온 적이 없으니 건너뛴다. */
+        if (!accessed && was_accessed)
+            pml4_invalidate_page(pml4, vpage);
+    }
+}
+
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+ * VPAGE in PML4, leaving the accessed and dirty bits alone.  Used
+ * to write-protect pages shared copy-on-write. */
+void pml4_set_writable(uint64_t *pml4, const void *vpage, bool writable) {
+    uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+    if (pte) {
+        if (writable)
+            *pte |= PTE_W;
+        else
+            *pte &= ~(uint64_t)PTE_W;
+
+        pml4_invalidate_page(pml4, vpage);
     }
 }
@@ -1,8 +1,8 @@
 #include "threads/palloc.h"
 
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -10,8 +10,10 @@
 #include <string.h>
 
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/spinlock.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -26,15 +28,63 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Free memory is kept as
+   blocks of 2**ORDER pages, each aligned (relative to the pool
+   base) to its own size, on one free list per order.  A request
+   for N pages takes the smallest free block of at least N pages,
+   splitting larger blocks in half as needed, and returns the
+   pages beyond N to the free lists.  Freeing a block merges it
+   with its "buddy", the other half of the block it was split
+   from, for as long as the buddy is free too.  Both directions
+   take O(PAL_ORDER_CNT) steps regardless of how full or
+   fragmented the pool is.
+
+   Each pool also keeps a short list of free pages that are
+   already filled with zeros.  The idle thread, which only runs
+   when nothing else wants the CPU, takes pages off the free
+   lists, zeroes them and puts them on that list, so that a
+   1-page PAL_ZERO request is usually served without a memset on
+   the caller's critical path.  Pre-zeroed pages are still free
+   memory: a 1-page request that the free lists cannot satisfy
+   takes one of them, and a larger one gives them all back to the
+   free lists first so that they can merge. */
+
+/* Marks a page that does not begin a free block. */
+#define ORDER_NONE 0xff
+
+/* Per-page buddy allocator state.  This is kept apart from the
+   pages themselves, so free pages are never written to and need
+   not even be mapped yet when palloc_init() frees them. */
+struct block_info {
+    struct list_elem elem; /* Element in pool's free list. */
+    void *owner;           /* Set by palloc_set_owner(). */
+    uint8_t order;         /* Order of the free block this page
+                              begins, or ORDER_NONE. */
+};
 
 /* A memory pool. */
 struct pool {
-    struct lock lock;        /* Mutual exclusion. */
-    struct bitmap *used_map; /* Bitmap of free pages. */
-    uint8_t *base;           /* Base of pool. */
+    struct spinlock lock;                   /* Mutual exclusion. */
+    uint8_t *base;                          /* Base of pool. */
+    size_t page_cnt;                        /* Number of pages in pool. */
+    struct block_info *blocks;              /* Per-page state. */
+    struct list free_lists[PAL_ORDER_CNT];  /* Free blocks, by order. */
+    size_t free_cnt[PAL_ORDER_CNT];         /* Length of each free list. */
+
+    /* Pre-zeroed pages. */
+    struct list zeroed;  /* Zeroed free pages. */
+    size_t zeroed_cnt;   /* Length of zeroed list. */
+    size_t zeroed_max;   /* Number of pages to keep zeroed. */
+    size_t zeroing_cnt;  /* Pages being zeroed by the idle thread. */
+    size_t zero_hits;    /* 1-page PAL_ZERO requests served from ZEROED. */
+    size_t zero_misses;  /* 1-page PAL_ZERO requests that had to memset. */
 };
 
+/* Most pages to keep pre-zeroed in a pool. */
+#define PREZERO_MAX 64
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
@@ -43,6 +93,12 @@ size_t user_page_limit = SIZE_MAX;
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool(const struct pool *, void *page);
+static struct pool *pool_of(void *page);
+static size_t pool_alloc(struct pool *, size_t page_cnt);
+static bool pool_take(struct pool *, size_t page_idx, size_t page_cnt);
+static void pool_free(struct pool *, size_t page_idx, size_t page_cnt);
+static void zeroed_flush(struct pool *);
+static bool prezero_wanted(const struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -214,16 +270,16 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
             else
                 NOT_REACHED();
 
-            pool_end = pool->base + bitmap_size(pool->used_map) * PGSIZE;
+            pool_end = pool->base + pool->page_cnt * PGSIZE;
             page_idx = pg_no(start) - pg_no(pool->base);
             if ((uint64_t)pool_end < end) {
                 page_cnt = ((uint64_t)pool_end - start) / PGSIZE;
-                bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                pool_free(pool, page_idx, page_cnt);
                 start = (uint64_t)pool_end;
                 goto split;
             } else {
                 page_cnt = ((uint64_t)end - start) / PGSIZE;
-                bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+                pool_free(pool, page_idx, page_cnt);
             }
         }
     }
@@ -255,19 +311,47 @@ uint64_t palloc_init(void) {
    FLAGS, in which case the kernel panics. */
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
     struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-    lock_acquire(&pool->lock);
-    size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-    lock_release(&pool->lock);
+    enum intr_level old_level;
+    size_t page_idx = SIZE_MAX;
     void *pages;
 
-    if (page_idx != BITMAP_ERROR)
+    bool zeroed = false;
+
+    if (page_cnt > 0) {
+        old_level = intr_disable();
+        spinlock_acquire(&pool->lock);
+        if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed_cnt > 0) {
+            struct list_elem *e = list_pop_front(&pool->zeroed);
+            page_idx = list_entry(e, struct block_info, elem) - pool->blocks;
+            pool->zeroed_cnt--;
+            pool->zero_hits++;
+            zeroed = true;
+        } else {
+            page_idx = pool_alloc(pool, page_cnt);
+            if (page_idx == SIZE_MAX && pool->zeroed_cnt > 0) {
+                if (page_cnt == 1) {
+                    struct list_elem *e = list_pop_front(&pool->zeroed);
+                    page_idx = list_entry(e, struct block_info, elem) - pool->blocks;
+                    pool->zeroed_cnt--;
+                } else {
+                    zeroed_flush(pool);
+                    page_idx = pool_alloc(pool, page_cnt);
+                }
+            }
+            if (page_cnt == 1 && (flags & PAL_ZERO))
+                pool->zero_misses++;
+        }
+        spinlock_release(&pool->lock);
+        intr_set_level(old_level);
+    }
+
+    if (page_idx != SIZE_MAX)
         pages = pool->base + PGSIZE * page_idx;
     else
         pages = NULL;
 
     if (pages) {
-        if (flags & PAL_ZERO)
+        if ((flags & PAL_ZERO) && !zeroed)
             memset(pages, 0, PGSIZE * page_cnt);
     } else {
         if (flags & PAL_ASSERT)
@@ -288,29 +372,71 @@ void *palloc_get_page(enum palloc_flags flags) {
     return palloc_get_multiple(flags, 1);
 }
 
+/* Tries to extend the PAGE_CNT allocated pages at PAGES to
+   NEW_CNT pages, by allocating the pages that follow them.
+   Returns true if successful, false if any of those pages is in
+   use or past the end of the pool. */
+bool palloc_grow(void *pages, size_t page_cnt, size_t new_cnt) {
+    struct pool *pool = pool_of(pages);
+    size_t page_idx = pg_no(pages) - pg_no(pool->base);
+    enum intr_level old_level;
+    bool success;
+
+    ASSERT(page_cnt > 0);
+    if (new_cnt <= page_cnt)
+        return true;
+    if (page_idx + new_cnt > pool->page_cnt)
+        return false;
+
+    old_level = intr_disable();
+    spinlock_acquire(&pool->lock);
+    success = pool_take(pool, page_idx + page_cnt, new_cnt - page_cnt);
+    spinlock_release(&pool->lock);
+    intr_set_level(old_level);
+    return success;
+}
+
+/* Records OWNER as the owner of each of the PAGE_CNT allocated
+   pages at PAGES, for palloc_get_owner() to return.  This lets a
+   sub-page allocator find the header of a multi-page region from
+   any address within it. */
+void palloc_set_owner(void *pages, size_t page_cnt, void *owner) {
+    struct pool *pool = pool_of(pages);
+    size_t page_idx = pg_no(pages) - pg_no(pool->base);
+
+    for (size_t i = 0; i < page_cnt; i++) pool->blocks[page_idx + i].owner = owner;
+}
+
+/* Returns the owner last recorded for allocated page PAGE by
+   palloc_set_owner(). */
+void *palloc_get_owner(void *page) {
+    struct pool *pool = pool_of(page);
+
+    return pool->blocks[pg_no(page) - pg_no(pool->base)].owner;
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void palloc_free_multiple(void *pages, size_t page_cnt) {
     struct pool *pool;
     size_t page_idx;
+    enum intr_level old_level;
 
     ASSERT(pg_ofs(pages) == 0);
     if (pages == NULL || page_cnt == 0)
         return;
 
-    if (page_from_pool(&kernel_pool, pages))
-        pool = &kernel_pool;
-    else if (page_from_pool(&user_pool, pages))
-        pool = &user_pool;
-    else
-        NOT_REACHED();
-
+    pool = pool_of(pages);
     page_idx = pg_no(pages) - pg_no(pool->base);
 
 #ifndef NDEBUG
+    for (size_t i = 0; i < page_cnt; i++) ASSERT(pool->blocks[page_idx + i].order == ORDER_NONE);
     memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
-    ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
-    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+    old_level = intr_disable();
+    spinlock_acquire(&pool->lock);
+    pool_free(pool, page_idx, page_cnt);
+    spinlock_release(&pool->lock);
+    intr_set_level(old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -318,29 +444,295 @@ void palloc_free_page(void *page) {
     palloc_free_multiple(page, 1);
 }
 
+/* Returns the number of free blocks of 2**ORDER pages in the user
+   pool, if PAL_USER is set in FLAGS, or else in the kernel pool. */
+size_t palloc_free_blocks(enum palloc_flags flags, int order) {
+    struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+    ASSERT(order >= 0 && order < PAL_ORDER_CNT);
+    return pool->free_cnt[order];
+}
+
+/* Stores the base address and the size in pages of the user
+   pool, if PAL_USER is set in FLAGS, or else of the kernel pool,
+   into *BASE and *PAGE_CNT.  Every page the pool hands out lies
+   in that range. */
+void palloc_pool_range(enum palloc_flags flags, void **base, size_t *page_cnt) {
+    struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+    *base = pool->base;
+    *page_cnt = pool->page_cnt;
+}
+
+/* Returns the number of free pages in the user pool, if PAL_USER
+   is set in FLAGS, or else in the kernel pool.  Pre-zeroed pages,
+   and pages that the idle thread is zeroing, count as free. */
+size_t palloc_free_pages(enum palloc_flags flags) {
+    struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+    enum intr_level old_level;
+    size_t cnt;
+
+    old_level = intr_disable();
+    spinlock_acquire(&pool->lock);
+    cnt = pool->zeroed_cnt + pool->zeroing_cnt;
+    for (int order = 0; order < PAL_ORDER_CNT; order++) cnt += pool->free_cnt[order] << order;
+    spinlock_release(&pool->lock);
+    intr_set_level(old_level);
+    return cnt;
+}
+
+/* Returns true if POOL is short of pre-zeroed pages and has free
+   pages to zero. */
+static bool prezero_wanted(const struct pool *pool) {
+    if (pool->zeroed_cnt + pool->zeroing_cnt >= pool->zeroed_max)
+        return false;
+    for (int order = 0; order < PAL_ORDER_CNT; order++)
+        if (pool->free_cnt[order] > 0)
+            return true;
+    return false;
+}
+
+/* Zeroes one free page of POOL and adds it to POOL's zeroed
+   list, if POOL wants more pre-zeroed pages.  Returns true if a
+   page was zeroed. */
+static bool prezero_page(struct pool *pool) {
+    enum intr_level old_level;
+    size_t page_idx = SIZE_MAX;
+
+    old_level = intr_disable();
+    spinlock_acquire(&pool->lock);
+    if (prezero_wanted(pool)) {
+        page_idx = pool_alloc(pool, 1);
+        pool->zeroing_cnt++;
+    }
+    spinlock_release(&pool->lock);
+    intr_set_level(old_level);
+    if (page_idx == SIZE_MAX)
+        return false;
+
+    memset(pool->base + PGSIZE * page_idx, 0, PGSIZE);
+
+    old_level = intr_disable();
+    spinlock_acquire(&pool->lock);
+    pool->zeroing_cnt--;
+    list_push_front(&pool->zeroed, &pool->blocks[page_idx].elem);
+    pool->zeroed_cnt++;
+    spinlock_release(&pool->lock);
+    intr_set_level(old_level);
+    return true;
+}
+
+/* Returns every pre-zeroed page of POOL to its free lists.  POOL's
+   lock must be held. */
+static void zeroed_flush(struct pool *pool) {
+    while (!list_empty(&pool->zeroed)) {
+        struct list_elem *e = list_pop_front(&pool->zeroed);
+        pool_free(pool, list_entry(e, struct block_info, elem) - pool->blocks, 1);
+    }
+    pool->zeroed_cnt = 0;
+}
+
+/* Zeroes one free page of each pool that is short of pre-zeroed
+   pages.  Returns true if it zeroed any.  Called by the idle
+   thread with interrupts on, so zeroing only uses time that no
+   thread wants and the idle thread never competes with, or
+   counts as, a ready thread. */
+bool palloc_prezero(void) {
+    bool progress = prezero_page(&kernel_pool);
+
+    if (prezero_page(&user_pool))
+        progress = true;
+    return progress;
+}
+
+/* Prints the free block counts of POOL, named NAME, by order. */
+static void print_pool_stats(const char *name, const struct pool *pool) {
+    size_t free_pages = 0;
+    int top = 0;
+
+    for (int order = 0; order < PAL_ORDER_CNT; order++)
+        if (pool->free_cnt[order] > 0) {
+            free_pages += pool->free_cnt[order] << order;
+            top = order;
+        }
+
+    printf("%s: %zu of %zu pages free, blocks by order:", name, free_pages, pool->page_cnt);
+    for (int order = 0; order <= top; order++) printf(" %zu", pool->free_cnt[order]);
+    printf("\n");
+    printf("%s: %zu pages pre-zeroed, %zu hits, %zu misses\n", name, pool->zeroed_cnt,
+           pool->zero_hits, pool->zero_misses);
+}
+
+/* Prints page allocator statistics. */
+void palloc_print_stats(void) {
+    print_pool_stats("Kernel pool", &kernel_pool);
+    print_pool_stats("User pool", &user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-    /* We'll put the pool's used_map at its base.
-       Calculate the space needed for the bitmap
-       and subtract it from the pool's size. */
+    /* We'll put the pool's per-page state at *BM_BASE, ahead of
+       the pools, and advance *BM_BASE past it. */
     uint64_t pgcnt = (end - start) / PGSIZE;
-    size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+    size_t bm_pages = DIV_ROUND_UP(pgcnt * sizeof(struct block_info), PGSIZE) * PGSIZE;
 
-    lock_init(&p->lock);
-    p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
+    spinlock_init(&p->lock, p == &kernel_pool ? "kernel pool" : "user pool");
     p->base = (void *)start;
+    p->page_cnt = pgcnt;
+    p->blocks = *bm_base;
+    for (int order = 0; order < PAL_ORDER_CNT; order++) {
+        list_init(&p->free_lists[order]);
+        p->free_cnt[order] = 0;
+    }
+    list_init(&p->zeroed);
+    p->zeroed_cnt = p->zeroing_cnt = 0;
+    p->zeroed_max = pgcnt / 32 < PREZERO_MAX ? pgcnt / 32 : PREZERO_MAX;
+    p->zero_hits = p->zero_misses = 0;
 
     // Mark all to unusable.
-    bitmap_set_all(p->used_map, true);
+    for (size_t i = 0; i < pgcnt; i++) p->blocks[i].order = ORDER_NONE;
 
     *bm_base += bm_pages;
 }
 
+/* Puts the block of 2**ORDER pages at PAGE_IDX on POOL's free
+   list for ORDER, without merging it. */
+static void push_block(struct pool *pool, size_t page_idx, int order) {
+    list_push_front(&pool->free_lists[order], &pool->blocks[page_idx].elem);
+    pool->blocks[page_idx].order = order;
+    pool->free_cnt[order]++;
+}
+
+/* Takes the free block at PAGE_IDX off its free list. */
+static void pull_block(struct pool *pool, size_t page_idx) {
+    int order = pool->blocks[page_idx].order;
+
+    list_remove(&pool->blocks[page_idx].elem);
+    pool->blocks[page_idx].order = ORDER_NONE;
+    pool->free_cnt[order]--;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX in POOL, merging
+   it with its buddy for as long as the buddy is also free. */
+static void free_block(struct pool *pool, size_t page_idx, int order) {
+    while (order < PAL_ORDER_CNT - 1) {
+        size_t buddy = page_idx ^ ((size_t)1 << order);
+
+        if (buddy >= pool->page_cnt || pool->blocks[buddy].order != order)
+            break;
+        pull_block(pool, buddy);
+        if (buddy < page_idx)
+            page_idx = buddy;
+        order++;
+    }
+    push_block(pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in POOL, as the
+   largest aligned blocks that cover them. */
+static void pool_free(struct pool *pool, size_t page_idx, size_t page_cnt) {
+    while (page_cnt > 0) {
+        int order = 0;
+
+        while (order < PAL_ORDER_CNT - 1 && page_idx % ((size_t)2 << order) == 0 &&
+               ((size_t)2 << order) <= page_cnt)
+            order++;
+        free_block(pool, page_idx, order);
+        page_idx += (size_t)1 << order;
+        page_cnt -= (size_t)1 << order;
+    }
+}
+
+/* Returns the index of the first page of the free block of POOL
+   that contains page PAGE_IDX, or SIZE_MAX if that page is not
+   free. */
+static size_t free_block_containing(const struct pool *pool, size_t page_idx) {
+    for (int order = 0; order < PAL_ORDER_CNT; order++) {
+        size_t head = page_idx & ~(((size_t)1 << order) - 1);
+
+        if (pool->blocks[head].order == order)
+            return head;
+    }
+    return SIZE_MAX;
+}
+
+/* Allocates exactly the PAGE_CNT pages starting at PAGE_IDX from
+   POOL, if they are all free, and returns true.  Otherwise,
+   returns false without allocating anything. */
+static bool pool_take(struct pool *pool, size_t page_idx, size_t page_cnt) {
+    size_t end = page_idx + page_cnt, first, last, i;
+
+    /* Check that free blocks cover the whole range.  The first block
+       may start before PAGE_IDX, so step to the end of each block
+       rather than by its size. */
+    for (i = page_idx; i < end; i = last + ((size_t)1 << pool->blocks[last].order)) {
+        last = free_block_containing(pool, i);
+        if (last == SIZE_MAX)
+            return false;
+    }
+
+    /* Take the blocks, then give back the parts of the first and
+       last blocks that stick out of the range. */
+    first = free_block_containing(pool, page_idx);
+    for (i = page_idx; i < end;) {
+        size_t head = free_block_containing(pool, i);
+
+        i = head + ((size_t)1 << pool->blocks[head].order);
+        pull_block(pool, head);
+    }
+    pool_free(pool, first, page_idx - first);
+    pool_free(pool, end, i - end);
+    return true;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or SIZE_MAX if no free block is big
+   enough. */
+static size_t pool_alloc(struct pool *pool, size_t page_cnt) {
+    int want = 0, order;
+    size_t page_idx;
+
+    while (((size_t)1 << want) < page_cnt)
+        if (++want >= PAL_ORDER_CNT)
+            return SIZE_MAX;
+
+    for (order = want; order < PAL_ORDER_CNT; order++)
+        if (!list_empty(&pool->free_lists[order]))
+            break;
+    if (order == PAL_ORDER_CNT)
+        return SIZE_MAX;
+
+    page_idx = list_entry(list_front(&pool->free_lists[order]), struct block_info, elem) -
+               pool->blocks;
+    pull_block(pool, page_idx);
+
+    /* Split down to the wanted order, freeing upper halves. */
+    while (order > want) {
+        order--;
+        push_block(pool, page_idx + ((size_t)1 << order), order);
+    }
+
+    /* Give back the pages past PAGE_CNT. */
+    if (page_cnt < ((size_t)1 << want))
+        pool_free(pool, page_idx + page_cnt, ((size_t)1 << want) - page_cnt);
+    return page_idx;
+}
+
+/* Returns the pool that PAGE belongs to. */
+static struct pool *pool_of(void *page) {
+    if (page_from_pool(&kernel_pool, page))
+        return &kernel_pool;
+    else if (page_from_pool(&user_pool, page))
+        return &user_pool;
+    else
+        NOT_REACHED();
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool page_from_pool(const struct pool *pool, void *page) {
     size_t page_no = pg_no(page);
     size_t start_page = pg_no(pool->base);
-    size_t end_page = start_page + bitmap_size(pool->used_map);
+    size_t end_page = start_page + pool->page_cnt;
     return page_no >= start_page && page_no < end_page;
 }
@@ -0,0 +1,262 @@
+#include "threads/slab.h"
+
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   Each cache carves page-sized "slabs" into objects of exactly
+   its object size (rounded up to OBJ_ALIGN), instead of rounding
+   every request up to a power of 2 as malloc() does, and each has
+   its own lock, so allocations of different object types do not
+   contend with each other or with malloc().
+
+   A slab starts with a header, followed by an array with one
+   free-list link per object, followed by the objects.  Keeping
+   the links out of the objects leaves free objects untouched, so
+   that a constructor's work survives a free/alloc cycle.
+
+   A cache keeps its slabs on three lists: partial (some objects
+   free), full (none free) and empty (all free).  Allocation takes
+   from a partial slab if there is one, then from an empty one,
+   and only then asks the page allocator for a new slab.  Up to
+   EMPTY_MAX empty slabs are kept on hand; further slabs that
+   become empty are returned to the page allocator. */
+
+/* Object alignment. */
+#define OBJ_ALIGN 8
+
+/* Number of empty slabs a cache keeps. */
+#define EMPTY_MAX 1
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* End of a slab's free list. */
+#define FREE_END UINT16_MAX
+
+/* An object cache. */
+struct kmem_cache {
+    const char *name;      /* Name, for statistics. */
+    size_t obj_size;       /* Size of each object in bytes. */
+    size_t objs_per_slab;  /* Number of objects in a slab. */
+    size_t obj_ofs;        /* Offset of first object in a slab. */
+    kmem_ctor *ctor;       /* Constructor, or a null pointer. */
+    struct list partial;   /* Slabs with some objects free. */
+    struct list full;      /* Slabs with no objects free. */
+    struct list empty;     /* Slabs with all objects free. */
+    size_t empty_cnt;      /* Number of slabs in `empty'. */
+    size_t slab_cnt;       /* Number of slabs in all three lists. */
+    size_t obj_cnt;        /* Number of objects allocated. */
+    struct lock lock;      /* Lock. */
+    char lock_name[16];    /* Name of `lock', e.g. "slab page". */
+    struct list_elem elem; /* Element in `caches'. */
+};
+
+/* A slab.  Stored at the start of its page. */
+struct slab {
+    unsigned magic;           /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache; /* Owning cache. */
+    struct list_elem elem;    /* Element in one of cache's lists. */
+    uint16_t free_cnt;        /* Number of free objects. */
+    uint16_t free;            /* First free object, or FREE_END. */
+    uint16_t next[];          /* Per object: next free object. */
+};
+
+/* All caches, for statistics. */
+static struct list caches;
+static struct lock caches_lock;
+
+static struct slab *slab_create(struct kmem_cache *);
+static struct slab *obj_to_slab(struct kmem_cache *, void *);
+static void *slab_obj(struct slab *, size_t idx);
+
+/* Initializes the slab allocator. */
+void kmem_init(void) {
+    list_init(&caches);
+    lock_init(&caches_lock);
+}
+
+/* Creates and returns a cache, named NAME, of SIZE-byte objects.
+   If CTOR is nonnull, it is called on every object when its slab
+   is created.  NAME is not copied, so it must outlive the cache.
+   Returns a null pointer if memory is not available. */
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, kmem_ctor *ctor) {
+    struct kmem_cache *c;
+    size_t n;
+
+    ASSERT(name != NULL);
+    ASSERT(size > 0);
+
+    c = malloc(sizeof *c);
+    if (c == NULL)
+        return NULL;
+
+    /* Fit as many objects as possible in a page, along with the
+       slab header and one free-list link per object. */
+    c->obj_size = ROUND_UP(size, OBJ_ALIGN);
+    n = (PGSIZE - sizeof(struct slab)) / (c->obj_size + sizeof(uint16_t));
+    while (n > 0 && ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), OBJ_ALIGN) +
+                            n * c->obj_size >
+                        PGSIZE)
+        n--;
+    ASSERT(n > 0);
+
+    c->name = name;
+    c->objs_per_slab = n;
+    c->obj_ofs = ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), OBJ_ALIGN);
+    c->ctor = ctor;
+    list_init(&c->partial);
+    list_init(&c->full);
+    list_init(&c->empty);
+    c->empty_cnt = c->slab_cnt = c->obj_cnt = 0;
+    snprintf(c->lock_name, sizeof c->lock_name, "slab %s", name);
+    lock_init_named(&c->lock, c->lock_name);
+
+    lock_acquire(&caches_lock);
+    list_push_back(&caches, &c->elem);
+    lock_release(&caches_lock);
+    return c;
+}
+
+/* Obtains and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *kmem_cache_alloc(struct kmem_cache *c) {
+    struct slab *s;
+    void *obj;
+
+    lock_acquire(&c->lock);
+    if (!list_empty(&c->partial))
+        s = list_entry(list_front(&c->partial), struct slab, elem);
+    else if (!list_empty(&c->empty)) {
+        s = list_entry(list_pop_front(&c->empty), struct slab, elem);
+        c->empty_cnt--;
+        list_push_front(&c->partial, &s->elem);
+    } else {
+        s = slab_create(c);
+        if (s == NULL) {
+            lock_release(&c->lock);
+            return NULL;
+        }
+        list_push_front(&c->partial, &s->elem);
+    }
+
+    /* Take the first free object. */
+    ASSERT(s->free != FREE_END);
+    obj = slab_obj(s, s->free);
+    s->free = s->next[s->free];
+    if (--s->free_cnt == 0) {
+        list_remove(&s->elem);
+        list_push_front(&c->full, &s->elem);
+    }
+    c->obj_cnt++;
+    lock_release(&c->lock);
+    return obj;
+}
+
+/* Frees OBJ, which must have been allocated from cache C. */
+void kmem_cache_free(struct kmem_cache *c, void *obj) {
+    struct slab *s;
+    size_t idx;
+
+    if (obj == NULL)
+        return;
+
+    s = obj_to_slab(c, obj);
+    idx = ((uint8_t *)obj - (uint8_t *)slab_obj(s, 0)) / c->obj_size;
+
+#ifndef NDEBUG
+    /* Clear the object to help detect use-after-free bugs, unless
+       it is supposed to keep its constructed state. */
+    if (c->ctor == NULL)
+        memset(obj, 0xcc, c->obj_size);
+#endif
+
+    lock_acquire(&c->lock);
+    s->next[idx] = s->free;
+    s->free = idx;
+    c->obj_cnt--;
+
+    /* Move the slab to the list it now belongs on. */
+    if (++s->free_cnt == c->objs_per_slab) {
+        list_remove(&s->elem);
+        if (c->empty_cnt < EMPTY_MAX) {
+            list_push_front(&c->empty, &s->elem);
+            c->empty_cnt++;
+        } else {
+            s->magic = 0;
+            c->slab_cnt--;
+            palloc_free_page(s);
+        }
+    } else if (s->free_cnt == 1) {
+        list_remove(&s->elem);
+        list_push_front(&c->partial, &s->elem);
+    }
+    lock_release(&c->lock);
+}
+
+/* Prints statistics for every cache. */
+void kmem_print_stats(void) {
+    struct list_elem *e;
+
+    lock_acquire(&caches_lock);
+    for (e = list_begin(&caches); e != list_end(&caches); e = list_next(e)) {
+        struct kmem_cache *c = list_entry(e, struct kmem_cache, elem);
+        printf("Slab cache %s: %zu objects in use, %zu slabs of %zu %zu-byte objects\n", c->name,
+               c->obj_cnt, c->slab_cnt, c->objs_per_slab, c->obj_size);
+    }
+    lock_release(&caches_lock);
+}
+
+/* Allocates a new slab for cache C, with all of its objects free
+   and constructed.  Returns a null pointer if memory is not
+   available. */
+static struct slab *slab_create(struct kmem_cache *c) {
+    struct slab *s = palloc_get_page(0);
+    size_t i;
+
+    if (s == NULL)
+        return NULL;
+
+    s->magic = SLAB_MAGIC;
+    s->cache = c;
+    s->free_cnt = c->objs_per_slab;
+    s->free = 0;
+    for (i = 0; i < c->objs_per_slab; i++) {
+        s->next[i] = i + 1 < c->objs_per_slab ? i + 1 : FREE_END;
+        if (c->ctor != NULL)
+            c->ctor(slab_obj(s, i));
+    }
+    c->slab_cnt++;
+    return s;
+}
+
+/* Returns the slab that OBJ, allocated from cache C, is inside. */
+static struct slab *obj_to_slab(struct kmem_cache *c, void *obj) {
+    struct slab *s = pg_round_down(obj);
+
+    /* Check that the slab is valid. */
+    ASSERT(s->magic == SLAB_MAGIC);
+    ASSERT(s->cache == c);
+
+    /* Check that the object is properly aligned for the slab. */
+    ASSERT(pg_ofs(obj) >= c->obj_ofs);
+    ASSERT((pg_ofs(obj) - c->obj_ofs) % c->obj_size == 0);
+
+    return s;
+}
+
+/* Returns the IDX'th object within slab S. */
+static void *slab_obj(struct slab *s, size_t idx) {
+    ASSERT(idx < s->cache->objs_per_slab);
+    return (uint8_t *)s + s->cache->obj_ofs + idx * s->cache->obj_size;
+}
@@ -0,0 +1,45 @@
+#include "threads/spinlock.h"
+
+#include <debug.h>
+#include <stddef.h>
+
+#include "threads/interrupt.h"
+
+/* Initializes LOCK, named NAME, as unlocked. */
+void spinlock_init(struct spinlock *lock, const char *name) {
+    ASSERT(lock != NULL);
+
+    lock->locked = 0;
+    lock->name = name;
+}
+
+/* Acquires LOCK, spinning until it becomes available.  LOCK must
+   not already be held, and interrupts must be off. */
+void spinlock_acquire(struct spinlock *lock) {
+    ASSERT(lock != NULL);
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(!spinlock_held(lock));
+
+    /* Spin on a plain read and only retry the exchange once the
+       lock looks free, so that waiters do not keep stealing the
+       cache line from the holder. */
+    while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE))
+        while (lock->locked) asm volatile("pause");
+}
+
+/* Releases LOCK, which must be held. */
+void spinlock_release(struct spinlock *lock) {
+    ASSERT(lock != NULL);
+    ASSERT(spinlock_held(lock));
+
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+/* Returns true if LOCK is held, false otherwise.  With interrupts
+   off and a single CPU, a held lock is always held by the code
+   that is running now. */
+bool spinlock_held(const struct spinlock *lock) {
+    ASSERT(lock != NULL);
+
+    return lock->locked;
+}
@@ -28,14 +28,31 @@ MODIFICATIONS.
 
 #include "threads/synch.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/* If true, named locks record contention statistics.
+   Controlled by kernel command-line option "-lockstat". */
+bool lock_profiling;
+
+/* All named locks, for lock_print_stats().  Initialized
+   statically because locks are named from the very first
+   initialization functions on. */
+static struct list named_locks = {{NULL, &named_locks.tail}, {&named_locks.head, NULL}};
+
 static bool higher_priority_sema(const struct list_elem *a_, const struct list_elem *b_,
                                  void *aux UNUSED);
+static bool more_wait_cycles(const struct list_elem *a_, const struct list_elem *b_,
+                             void *aux UNUSED);
+static void lock_stats_register(struct lock_stats *, const char *name);
+static void lock_stats_acquired(struct lock_stats *);
+static void lock_stats_released(struct lock_stats *);
+static int donated_priority(struct thread *);
 
 /* Initializes semaphore SEMA to VALUE. A semaphore is a
 nonnegative integer along with two atomic operators for
@@ -51,6 +68,7 @@ void sema_init(struct semaphore *sema, unsigned value) {
 
     sema->value = value;
     list_init(&sema->waiters);
+    sema->stats = NULL;
 }
 
 /* 세마포어의 Wait() 또는 P 연산.
@@ -58,6 +76,7 @@ void sema_init(struct semaphore *sema, unsigned value) {
 */
 void sema_down(struct semaphore *sema) {
     enum intr_level old_level;
+    uint64_t wait_start = 0;
 
     ASSERT(sema != NULL);
 
@@ -66,12 +85,18 @@ void sema_down(struct semaphore *sema) {
 
     old_level = intr_disable();  // 인터럽트 OFF
 
+    if (sema->value == 0 && sema->stats != NULL && lock_profiling)
+        wait_start = rdtsc();
     while (sema->value == 0) {  // 만약 sema가 "0" 이면
         // list_push_back(&sema->waiters, &thread_current()->elem);
         list_insert_ordered(&sema->waiters, &thread_current()->elem, higher_priority, NULL);
         thread_block();  // wait_list 에 넣기 => 쓰레드 블록상태
     }
     sema->value--;
+    if (wait_start != 0) {
+        sema->stats->contended++;
+        sema->stats->wait_cycles += rdtsc() - wait_start;
+    }
 
     intr_set_level(old_level);  // 인터럽트 ON
 }
@@ -172,6 +197,66 @@ void lock_init(struct lock *lock) {
 
     lock->holder = NULL;
     sema_init(&lock->semaphore, 1);
+    memset(&lock->stats, 0, sizeof lock->stats);
+}
+
+/* Initializes LOCK like lock_init() and gives it NAME, so that
+   its contention statistics are recorded and reported by
+   lock_print_stats().  LOCK must never be freed, since it stays
+   on the list of named locks until power off. */
+void lock_init_named(struct lock *lock, const char *name) {
+    lock_init(lock);
+    lock->semaphore.stats = &lock->stats;
+    lock_stats_register(&lock->stats, name);
+}
+
+/* Names S and adds it to the list of named locks. */
+static void lock_stats_register(struct lock_stats *s, const char *name) {
+    enum intr_level old_level;
+
+    ASSERT(name != NULL);
+
+    s->name = name;
+    old_level = intr_disable();
+    list_push_back(&named_locks, &s->elem);
+    intr_set_level(old_level);
+}
+
+/* Records that the lock owning S was just acquired. */
+static void lock_stats_acquired(struct lock_stats *s) {
+    if (lock_profiling && s->name != NULL) {
+        s->acquisitions++;
+        s->acquired_at = rdtsc();
+    }
+}
+
+/* Records that the lock owning S is about to be released. */
+static void lock_stats_released(struct lock_stats *s) {
+    if (lock_profiling && s->name != NULL && s->acquired_at != 0) {
+        uint64_t held = rdtsc() - s->acquired_at;
+        if (held > s->max_hold_cycles)
+            s->max_hold_cycles = held;
+        s->acquired_at = 0;
+    }
+}
+
+/* Prints the statistics of every named lock, most waited-for
+   first, if lock profiling is enabled. */
+void lock_print_stats(void) {
+    struct list_elem *e;
+
+    if (!lock_profiling)
+        return;
+
+    list_sort(&named_locks, more_wait_cycles, NULL);
+    printf("Lock statistics (TSC cycles):\n");
+    printf("%-16s %10s %10s %14s %14s\n", "name", "acquired", "contended", "total wait",
+           "max hold");
+    for (e = list_begin(&named_locks); e != list_end(&named_locks); e = list_next(e)) {
+        struct lock_stats *s = list_entry(e, struct lock_stats, elem);
+        printf("%-16s %10" PRIu64 " %10" PRIu64 " %14" PRIu64 " %14" PRIu64 "\n", s->name,
+               s->acquisitions, s->contended, s->wait_cycles, s->max_hold_cycles);
+    }
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -190,15 +275,16 @@ void lock_acquire(struct lock *lock) {
     struct thread *now_t = thread_current();
     enum intr_level old_level = intr_disable();
     now_t->wait_on_lock = lock;
-    if (hold_t != NULL && hold_t->priority < now_t->priority) {
+    if (!thread_mlfqs && hold_t != NULL && hold_t->priority < now_t->priority) {
         list_insert_ordered(&hold_t->donation_list, &now_t->donation_elem, lower_priority, NULL);
-        hold_t->priority = get_high_donation(hold_t);
+        thread_change_priority(hold_t, get_high_donation(hold_t));
         set_donations_priority(hold_t);
     }
     sema_down(&lock->semaphore);
 
     lock->holder = thread_current();
     lock->holder->wait_on_lock = NULL;
+    lock_stats_acquired(&lock->stats);
     intr_set_level(old_level);
 }
 
@@ -215,8 +301,10 @@ bool lock_try_acquire(struct lock *lock) {
     ASSERT(!lock_held_by_current_thread(lock));
 
     success = sema_try_down(&lock->semaphore);
-    if (success)
+    if (success) {
         lock->holder = thread_current();
+        lock_stats_acquired(&lock->stats);
+    }
     return success;
 }
 
@@ -231,11 +319,10 @@ void lock_release(struct lock *lock) {
     ASSERT(lock_held_by_current_thread(lock));
     struct thread *t = thread_current();
     enum intr_level old_level = intr_disable();
-    remove_donations(lock, t);
-    if (!list_empty(&t->donation_list)) {
-        t->priority = get_high_donation(t);
-    } else {
-        t->priority = t->o_priority;
+    lock_stats_released(&lock->stats);
+    if (!thread_mlfqs) {
+        remove_donations(lock, t);
+        t->priority = donated_priority(t);
     }
 
     lock->holder = NULL;
@@ -252,6 +339,260 @@ bool lock_held_by_current_thread(const struct lock *lock) {
     return lock->holder == thread_current();
 }
 
+/* Returns the priority T should run at given the donations it
+   currently receives, through locks and through rwlocks. */
+static int donated_priority(struct thread *t) {
+    int priority;
+
+    if (!list_empty(&t->donation_list))
+        priority = get_high_donation(t);
+    else
+        priority = t->o_priority;
+
+    for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+        struct rwlock *rw = t->rwlock_holds[i].rwlock;
+        struct list *waiters[2];
+
+        if (rw == NULL)
+            continue;
+        waiters[0] = &rw->read_waiters;
+        waiters[1] = &rw->write_waiters;
+        for (int j = 0; j < 2; j++)
+            if (!list_empty(waiters[j])) {
+                struct thread *w =
+                    list_entry(list_max(waiters[j], lower_priority, NULL), struct thread, elem);
+                if (w->priority > priority)
+                    priority = w->priority;
+            }
+    }
+    return priority;
+}
+
+/* Initializes RW as unlocked. */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    rw->writer = NULL;
+    rw->readers = 0;
+    list_init(&rw->holders);
+    list_init(&rw->read_waiters);
+    list_init(&rw->write_waiters);
+    memset(&rw->stats, 0, sizeof rw->stats);
+}
+
+/* Initializes RW like rwlock_init() and gives it NAME, so that
+   its contention statistics are reported by lock_print_stats().
+   RW must never be freed. */
+void rwlock_init_named(struct rwlock *rw, const char *name) {
+    rwlock_init(rw);
+    lock_stats_register(&rw->stats, name);
+}
+
+/* Returns true if T has a free rwlock_hold slot, so that it may
+   acquire one more rwlock. */
+static bool rwlock_can_hold(const struct thread *t) {
+    for (int i = 0; i < RWLOCK_HOLD_MAX; i++)
+        if (t->rwlock_holds[i].rwlock == NULL)
+            return true;
+    return false;
+}
+
+/* Records that T now holds RW. */
+static void rwlock_hold(struct rwlock *rw, struct thread *t) {
+    for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+        struct rwlock_hold *h = &t->rwlock_holds[i];
+        if (h->rwlock == NULL) {
+            h->rwlock = rw;
+            h->thread = t;
+            list_push_back(&rw->holders, &h->elem);
+            return;
+        }
+    }
+    NOT_REACHED();
+}
+
+/* Records that T no longer holds RW. */
+static void rwlock_unhold(struct rwlock *rw, struct thread *t) {
+    for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+        struct rwlock_hold *h = &t->rwlock_holds[i];
+        if (h->rwlock == rw) {
+            list_remove(&h->elem);
+            h->rwlock = NULL;
+            return;
+        }
+    }
+}
+
+/* Donates the running thread's priority to every holder of RW,
+   then blocks it on WAITERS until a releasing thread hands it
+   access to RW. */
+static void rwlock_wait(struct rwlock *rw, struct list *waiters) {
+    struct thread *curr = thread_current();
+    uint64_t wait_start = lock_profiling && rw->stats.name != NULL ? rdtsc() : 0;
+    struct list_elem *e;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!thread_mlfqs)
+        for (e = list_begin(&rw->holders); e != list_end(&rw->holders); e = list_next(e)) {
+            struct thread *holder = list_entry(e, struct rwlock_hold, elem)->thread;
+            if (holder->priority < curr->priority) {
+                thread_change_priority(holder, curr->priority);
+                set_donations_priority(holder);
+            }
+        }
+
+    list_push_back(waiters, &curr->elem);
+    thread_block();
+
+    if (wait_start != 0) {
+        rw->stats.contended++;
+        rw->stats.wait_cycles += rdtsc() - wait_start;
+    }
+}
+
+/* Wakes up T, which was just handed an rwlock, at a priority that
+   includes the donations of the threads still waiting for it. */
+static void rwlock_granted(struct thread *t) {
+    if (!thread_mlfqs)
+        t->priority = donated_priority(t);
+    thread_unblock(t);
+}
+
+/* Hands RW to waiting threads after a release.  Every waiting
+   reader is admitted if the lock was write-locked, or if no
+   writer is waiting; otherwise the highest-priority writer is. */
+static void rwlock_wake(struct rwlock *rw, bool was_writer) {
+    if (rw->writer != NULL || rw->readers > 0)
+        return;
+
+    if (!list_empty(&rw->read_waiters) && (was_writer || list_empty(&rw->write_waiters))) {
+        while (!list_empty(&rw->read_waiters)) {
+            struct thread *t = list_entry(list_pop_front(&rw->read_waiters), struct thread, elem);
+            rw->readers++;
+            rwlock_hold(rw, t);
+            rwlock_granted(t);
+        }
+    } else if (!list_empty(&rw->write_waiters)) {
+        struct list_elem *e = list_max(&rw->write_waiters, lower_priority, NULL);
+        struct thread *t = list_entry(e, struct thread, elem);
+
+        list_remove(e);
+        rw->writer = t;
+        rwlock_hold(rw, t);
+        rwlock_granted(t);
+    }
+}
+
+/* Acquires RW for reading, sleeping until no writer holds or
+   waits for it.  Any number of threads may read at once, but
+   each thread may hold at most RWLOCK_HOLD_MAX rwlocks, so that
+   all of its holds can receive donations.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_read(struct rwlock *rw) {
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+    ASSERT(!rwlock_held_by_current_thread(rw));
+    ASSERT(rwlock_can_hold(thread_current()));
+
+    old_level = intr_disable();
+    if (rw->writer != NULL || !list_empty(&rw->write_waiters))
+        rwlock_wait(rw, &rw->read_waiters);
+    else {
+        rw->readers++;
+        rwlock_hold(rw, thread_current());
+    }
+    if (lock_profiling && rw->stats.name != NULL)
+        rw->stats.acquisitions++;
+    intr_set_level(old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  Like rwlock_acquire_read(), counts against the running
+   thread's RWLOCK_HOLD_MAX.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_write(struct rwlock *rw) {
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+    ASSERT(!rwlock_held_by_current_thread(rw));
+    ASSERT(rwlock_can_hold(thread_current()));
+
+    old_level = intr_disable();
+    if (rw->writer != NULL || rw->readers > 0)
+        rwlock_wait(rw, &rw->write_waiters);
+    else {
+        rw->writer = thread_current();
+        rwlock_hold(rw, thread_current());
+    }
+    lock_stats_acquired(&rw->stats);
+    intr_set_level(old_level);
+}
+
+/* Releases read access to RW, which the current thread must
+   hold. */
+void rwlock_release_read(struct rwlock *rw) {
+    struct thread *curr = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(rw->readers > 0 && rw->writer == NULL);
+    ASSERT(rwlock_held_by_current_thread(rw));
+
+    old_level = intr_disable();
+    rw->readers--;
+    rwlock_unhold(rw, curr);
+    rwlock_wake(rw, false);
+    if (!thread_mlfqs)
+        thread_change_priority(curr, donated_priority(curr));
+    intr_set_level(old_level);
+
+    thread_try_yield();
+}
+
+/* Releases write access to RW, which the current thread must
+   hold. */
+void rwlock_release_write(struct rwlock *rw) {
+    struct thread *curr = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(rw != NULL);
+    ASSERT(rw->writer == curr);
+
+    old_level = intr_disable();
+    lock_stats_released(&rw->stats);
+    rw->writer = NULL;
+    rwlock_unhold(rw, curr);
+    rwlock_wake(rw, true);
+    if (!thread_mlfqs)
+        thread_change_priority(curr, donated_priority(curr));
+    intr_set_level(old_level);
+
+    thread_try_yield();
+}
+
+/* Returns true if the current thread holds RW, for reading or
+   writing. */
+bool rwlock_held_by_current_thread(const struct rwlock *rw) {
+    struct thread *curr = thread_current();
+
+    ASSERT(rw != NULL);
+
+    if (rw->writer == curr)
+        return true;
+    for (int i = 0; i < RWLOCK_HOLD_MAX; i++)
+        if (curr->rwlock_holds[i].rwlock == rw)
+            return true;
+    return false;
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
     struct list_elem elem;           /* List element. */
@@ -342,3 +683,12 @@ static bool higher_priority_sema(const struct list_elem *a_, const struct list_e
 
     return a->priority > b->priority;
 }
+
+/* Orders named locks by decreasing total wait time. */
+static bool more_wait_cycles(const struct list_elem *a_, const struct list_elem *b_,
+                             void *aux UNUSED) {
+    const struct lock_stats *a = list_entry(a_, struct lock_stats, elem);
+    const struct lock_stats *b = list_entry(b_, struct lock_stats, elem);
+
+    return a->wait_cycles > b->wait_cycles;
+}
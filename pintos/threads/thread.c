@@ -6,12 +6,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/spinlock.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -26,13 +30,25 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+#if PRI_MAX - PRI_MIN + 1 > 64
+#error ready_mask needs one bit per priority level
+#endif
+
+/* Run queue of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
 
-/* List of processes in THREAD_BLOCKED state, that is , processes
-   that are blocked until they are woken up by the OS*/
-static struct list sleep_list;  // 추가
+   There is one FIFO list per priority level.  Bit P of
+   ready_mask is set iff ready_queues[P] is non-empty, so the
+   highest ready priority is a single find-last-set on the mask
+   and both enqueue and dequeue run in constant time. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt; /* # of threads in the run queue. */
+
+/* List of all processes.  Processes are added to this list
+   when they are created and removed when they exit.
+   Only the MLFQS walks it, once per second. */
+static struct list all_list;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -46,15 +62,38 @@ static struct lock tid_lock;
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Cache of the pages of dead threads, reused by thread_create()
+   so that fork/exec churn does not go through palloc (and its
+   bitmap scan) for every thread.  init_thread() clears just
+   `struct thread', so a recycled page is never zeroed as a
+   whole; the rest of it is stack. */
+#define THREAD_CACHE_MAX 16
+static void *thread_cache[THREAD_CACHE_MAX];
+static int thread_cache_cnt;
+static bool thread_cache_enabled = true;
+static struct spinlock thread_cache_lock;
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
 static long long user_ticks;   /* # of timer ticks in user programs. */
+static long long switch_cnt;   /* # of context switches. */
 
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
 
+/* MLFQS state.  Priorities are recomputed every PRI_INTERVAL
+   ticks, but only a thread that was charged a tick since the
+   last recomputation can have a new priority, so just those
+   (at most PRI_INTERVAL of them) are recorded and recomputed.
+   The once-per-second recent_cpu decay is the only pass over
+   all threads. */
+#define PRI_INTERVAL 4
+static fixed_t load_avg;                      /* System load average. */
+static struct thread *charged[PRI_INTERVAL]; /* Threads charged since last recompute. */
+static int charged_cnt;                       /* # of entries in charged[]. */
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
@@ -68,6 +107,15 @@ static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static struct thread *thread_page_alloc(void);
+static void thread_page_free(struct thread *);
+static void ready_queue_push(struct thread *);
+static void ready_queue_remove(struct thread *);
+static struct thread *ready_queue_pop(void);
+static int ready_queue_top_priority(void);
+static void mlfqs_tick(struct thread *);
+static void mlfqs_update_priority(struct thread *);
+static void mlfqs_update_every_second(void);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -107,10 +155,14 @@ void thread_init(void) {
     lgdt(&gdt_ds);
 
     /* Init the globla thread context */
-    lock_init(&tid_lock);
-    list_init(&ready_list);
+    lock_init_named(&tid_lock, "tid");
+    for (int pri = PRI_MIN; pri <= PRI_MAX; pri++) list_init(&ready_queues[pri]);
+    ready_mask = 0;
+    ready_cnt = 0;
+    list_init(&all_list);
+    spinlock_init(&thread_cache_lock, "thread cache");
+    load_avg = fp_from_int(0);
     list_init(&destruction_req);
-    list_init(&sleep_list);  // 추가
 
     /* Set up a thread structure for the running thread. */
     initial_thread = running_thread();
@@ -137,7 +189,7 @@ void thread_start(void) {
 /* Called by the timer interrupt handler at each timer tick.
    Thus, this function runs in an external interrupt context. */
 void thread_tick(void) {
-    struct thread *t, *wake;
+    struct thread *t;
     t = thread_current();
 
     /* Update statistics. */
@@ -150,6 +202,9 @@ void thread_tick(void) {
     else
         kernel_ticks++;
 
+    if (thread_mlfqs)
+        mlfqs_tick(t);
+
     /* Enforce preemption. */
     thread_ticks++;
 
@@ -163,6 +218,15 @@ void thread_print_stats(void) {
            kernel_ticks, user_ticks);
 }
 
+/* Returns the number of context switches since boot. */
+long long thread_switch_count(void) {
+    enum intr_level old_level = intr_disable();
+    long long cnt = switch_cnt;
+
+    intr_set_level(old_level);
+    return cnt;
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -185,13 +249,21 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     ASSERT(function != NULL);
 
     /* Allocate thread. */
-    t = palloc_get_page(PAL_ZERO);
+    t = thread_page_alloc();
     if (t == NULL)
         return TID_ERROR;
 
-    /* Initialize thread. */
+    /* Initialize thread.  Under the MLFQS the new thread inherits
+       the creator's niceness and recent_cpu, and PRIORITY is
+       ignored in favor of the computed priority. */
     init_thread(t, name, priority);
     tid = t->tid = allocate_tid();
+    if (thread_mlfqs) {
+        t->nice = thread_current()->nice;
+        t->recent_cpu = thread_current()->recent_cpu;
+        mlfqs_update_priority(t);
+        priority = t->priority;
+    }
 
     /* Call the kernel_thread if it scheduled.
      * Note) rdi is 1st argument, and rsi is 2nd argument. */
@@ -204,9 +276,14 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     t->tf.cs = SEL_KCSEG;
     t->tf.eflags = FLAG_IF;
 
-    t->fdt = palloc_get_page(PAL_ZERO);
+    /* The table is 1 kB, so it comes from malloc() rather than
+       taking a whole page. */
+    t->fdt = calloc(FDT_MAX_SIZE, sizeof *t->fdt);
     if (t->fdt == NULL) {
-        palloc_free_page(t);
+        enum intr_level old_level = intr_disable();
+        list_remove(&t->allelem);
+        thread_page_free(t);
+        intr_set_level(old_level);
         return TID_ERROR;
     }
     t->fd_idx = 2;
@@ -275,11 +352,10 @@ void thread_unblock(struct thread *t) {
     old_level = intr_disable();           // 인터럽트 끄기 -> 현재 동작이 원자적으로 작동하도록
     ASSERT(t->status == THREAD_BLOCKED);  // 현재 스레드가 블록상태여야함.
 
-    // list_push_back(&ready_list, &t->elem);  // 현재 스레드를 ready thread list에 넣기
-    list_insert_ordered(&ready_list, &t->elem, higher_priority,
-                        NULL);  // 현재 스레드를 ready thread list에 넣기
+    ready_queue_push(t);  // 현재 스레드를 우선순위에 맞는 ready queue에 넣기
+    t->status = THREAD_READY;  // ready 상태로 변경
+    trace(TRACE_UNBLOCK, t->tid, t->priority);
 
-    t->status = THREAD_READY;   // ready 상태로 변경
     intr_set_level(old_level);  // 복원
 }
 
@@ -323,6 +399,10 @@ void thread_exit(void) {
     /* Just set our status to dying and schedule another process.
        We will be destroyed during the call to schedule_tail(). */
     intr_disable();
+    list_remove(&thread_current()->allelem);
+    for (int i = 0; i < charged_cnt; i++)
+        if (charged[i] == thread_current())
+            charged[i] = charged[--charged_cnt];
     do_schedule(THREAD_DYING);
     NOT_REACHED();
 }
@@ -337,25 +417,26 @@ void thread_yield(void) {
 
     old_level = intr_disable();  // interrupt를 비활성화 시키고 이전 interrupt 상태를 반환
     if (curr != idle_thread)     // 현재 스레드가 유휴 스레드가 아니면,
-
-        // list_push_back(&ready_list, &curr->elem);  // 현재 스레드를 ready list의 맨 마지막에 넣음
-        list_insert_ordered(&ready_list, &curr->elem, higher_priority, NULL);
+        ready_queue_push(curr);  // 같은 우선순위 큐의 맨 마지막에 넣음
     do_schedule(THREAD_READY);  // 죽여야할 애들 다 죽이고, 현재 스레드는 주어진
     intr_set_level(old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority) {
-    int top_priority = -1;
+    int top_priority;
     struct thread *curr = thread_current();
 
+    /* The MLFQS computes priorities itself. */
+    if (thread_mlfqs)
+        return;
+
     if (curr->priority == curr->o_priority) {
         curr->priority = new_priority;
     }
     curr->o_priority = new_priority;
 
-    if (!list_empty(&ready_list))
-        top_priority = list_entry(list_front(&ready_list), struct thread, elem)->priority;
+    top_priority = ready_queue_top_priority();
 
     if (top_priority > curr->priority)
         thread_yield();
@@ -366,27 +447,109 @@ int thread_get_priority(void) {
     return thread_current()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED) {
-    /* TODO: Your implementation goes here */
+/* Sets the current thread's nice value to NICE, recomputes its
+   priority and yields if it no longer has the highest one. */
+void thread_set_nice(int nice) {
+    struct thread *curr = thread_current();
+    enum intr_level old_level;
+
+    ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+    old_level = intr_disable();
+    curr->nice = nice;
+    if (thread_mlfqs)
+        mlfqs_update_priority(curr);
+    intr_set_level(old_level);
+
+    if (ready_queue_top_priority() > curr->priority)
+        thread_yield();
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+    return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+    enum intr_level old_level = intr_disable();
+    int load_avg_100 = fp_to_int_round(fp_mul_int(load_avg, 100));
+    intr_set_level(old_level);
+    return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void) {
-    /* TODO: Your implementation goes here */
-    return 0;
+    enum intr_level old_level = intr_disable();
+    int recent_cpu_100 = fp_to_int_round(fp_mul_int(thread_current()->recent_cpu, 100));
+    intr_set_level(old_level);
+    return recent_cpu_100;
+}
+
+/* Charges the running thread T one tick of CPU time and runs
+   the periodic MLFQS updates.  Called from thread_tick(), in the
+   timer interrupt. */
+static void mlfqs_tick(struct thread *t) {
+    int64_t now = timer_ticks();
+
+    if (t != idle_thread) {
+        int i;
+
+        t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+        for (i = 0; i < charged_cnt; i++)
+            if (charged[i] == t)
+                break;
+        if (i == charged_cnt && charged_cnt < PRI_INTERVAL)
+            charged[charged_cnt++] = t;
+    }
+
+    if (now % TIMER_FREQ == 0)
+        mlfqs_update_every_second();
+    else if (now % PRI_INTERVAL == 0) {
+        for (int i = 0; i < charged_cnt; i++) mlfqs_update_priority(charged[i]);
+    } else
+        return;
+
+    charged_cnt = 0;
+    if (t != idle_thread && ready_queue_top_priority() > t->priority)
+        intr_yield_on_return();
+}
+
+/* Recomputes T's priority from its recent_cpu and niceness:
+   priority = PRI_MAX - (recent_cpu / 4) - (nice * 2). */
+static void mlfqs_update_priority(struct thread *t) {
+    int priority;
+
+    if (t == idle_thread)
+        return;
+
+    priority = PRI_MAX - fp_to_int(fp_div_int(t->recent_cpu, 4)) - t->nice * 2;
+    if (priority < PRI_MIN)
+        priority = PRI_MIN;
+    else if (priority > PRI_MAX)
+        priority = PRI_MAX;
+    thread_change_priority(t, priority);
+}
+
+/* Updates load_avg, then decays every thread's recent_cpu and
+   recomputes its priority.  Called once per second. */
+static void mlfqs_update_every_second(void) {
+    int ready_threads = ready_cnt + (thread_current() != idle_thread ? 1 : 0);
+    fixed_t twice_load, decay;
+    struct list_elem *e;
+
+    load_avg = fp_add(fp_mul(fp_div(fp_from_int(59), fp_from_int(60)), load_avg),
+                      fp_div_int(fp_from_int(ready_threads), 60));
+
+    twice_load = fp_mul_int(load_avg, 2);
+    decay = fp_div(twice_load, fp_add_int(twice_load, 1));
+    for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+        struct thread *t = list_entry(e, struct thread, allelem);
+        if (t == idle_thread)
+            continue;
+        t->recent_cpu = fp_add_int(fp_mul(decay, t->recent_cpu), t->nice);
+        mlfqs_update_priority(t);
+    }
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -409,6 +572,20 @@ static void idle(void *idle_started_ UNUSED) {
         intr_disable();
         thread_block();
 
+        /* Spend the idle time zeroing free pages for palloc, one
+           at a time, until a thread becomes ready or there is
+           nothing left to zero. */
+        intr_enable();
+        while (ready_mask == 0 && palloc_prezero())
+            continue;
+        intr_disable();
+        if (ready_mask != 0)
+            continue;
+
+        /* Nothing is ready to run, so stop the periodic tick if
+           tickless idle is enabled. */
+        timer_idle_enter();
+
         /* Re-enable interrupts and wait for the next one.
 
            The `sti' instruction disables interrupts until the
@@ -422,6 +599,15 @@ static void idle(void *idle_started_ UNUSED) {
            See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
            7.11.1 "HLT Instruction". */
         asm volatile("sti; hlt" : : : "memory");
+
+        /* A one-shot that was only chained toward the end of the
+           idle period leaves nothing to do, so halt again.
+           Otherwise restore the periodic tick if some other
+           interrupt woke us up first. */
+        intr_disable();
+        while (ready_mask == 0 && timer_idle_rearmed())
+            asm volatile("sti; hlt; cli" : : : "memory");
+        timer_idle_exit();
     }
 }
 
@@ -437,6 +623,8 @@ static void kernel_thread(thread_func *function, void *aux) {
 /* Does basic initialization of T as a blocked thread named
    NAME. */
 static void init_thread(struct thread *t, const char *name, int priority) {
+    enum intr_level old_level;
+
     ASSERT(t != NULL);
     ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
     ASSERT(name != NULL);
@@ -450,8 +638,14 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     list_init(&t->donation_list);
     t->wait_on_lock = NULL;
     t->wake_time = -1;
+    t->nice = NICE_DEFAULT;
+    t->recent_cpu = fp_from_int(0);
     t->magic = THREAD_MAGIC;
 
+    old_level = intr_disable();
+    list_push_back(&all_list, &t->allelem);
+    intr_set_level(old_level);
+
     // FD 테이블 초기화
     t->fdt = NULL;
 
@@ -470,10 +664,73 @@ static void init_thread(struct thread *t, const char *name, int priority) {
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. */
 static struct thread *next_thread_to_run(void) {
-    if (list_empty(&ready_list))
+    if (ready_mask == 0)
         return idle_thread;
     else
-        return list_entry(list_pop_front(&ready_list), struct thread, elem);
+        return ready_queue_pop();
+}
+
+/* Appends T to the run queue of its current priority. */
+static void ready_queue_push(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+    list_push_back(&ready_queues[t->priority], &t->elem);
+    ready_mask |= 1ULL << t->priority;
+    ready_cnt++;
+}
+
+/* Removes T from the run queue of its current priority.  T's
+   priority must not have changed since it was queued. */
+static void ready_queue_remove(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(t->status == THREAD_READY);
+
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[t->priority]))
+        ready_mask &= ~(1ULL << t->priority);
+    ready_cnt--;
+}
+
+/* Removes and returns the oldest thread of the highest ready
+   priority.  The run queue must not be empty. */
+static struct thread *ready_queue_pop(void) {
+    int pri = ready_queue_top_priority();
+    struct thread *t;
+
+    ASSERT(pri >= PRI_MIN);
+    t = list_entry(list_pop_front(&ready_queues[pri]), struct thread, elem);
+    if (list_empty(&ready_queues[pri]))
+        ready_mask &= ~(1ULL << pri);
+    ready_cnt--;
+    return t;
+}
+
+/* Returns the highest priority among ready threads, or -1 if no
+   thread is ready. */
+static int ready_queue_top_priority(void) {
+    if (ready_mask == 0)
+        return -1;
+    return 63 - __builtin_clzll(ready_mask);
+}
+
+/* Sets T's effective priority to PRIORITY.  If T is waiting in
+   the run queue, it is moved to the queue for its new priority
+   so that the run queue stays consistent with T->priority. */
+void thread_change_priority(struct thread *t, int priority) {
+    enum intr_level old_level;
+
+    ASSERT(is_thread(t));
+    ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
+
+    old_level = intr_disable();
+    if (t->status == THREAD_READY && t->priority != priority) {
+        ready_queue_remove(t);
+        t->priority = priority;
+        ready_queue_push(t);
+    } else
+        t->priority = priority;
+    intr_set_level(old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -583,7 +840,7 @@ static void do_schedule(int status) {
     ASSERT(thread_current()->status == THREAD_RUNNING);
     while (!list_empty(&destruction_req)) {
         struct thread *victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
-        palloc_free_page(victim);
+        thread_page_free(victim);
     }
     thread_current()->status = status;
     schedule();
@@ -608,6 +865,9 @@ static void schedule(void) {
 #endif
 
     if (curr != next) {
+        trace(TRACE_SCHEDULE, curr->tid, next->tid);
+        switch_cnt++;
+
         /* If the thread we switched from is dying, destroy its struct
            thread. This must happen late so that thread_exit() doesn't
            pull out the rug under itself.
@@ -626,6 +886,57 @@ static void schedule(void) {
     }
 }
 
+/* Returns a page for a new thread, from the cache of dead
+   threads' pages if possible.  The page is not zeroed. */
+static struct thread *thread_page_alloc(void) {
+    struct thread *t = NULL;
+    enum intr_level old_level;
+
+    old_level = intr_disable();
+    spinlock_acquire(&thread_cache_lock);
+    if (thread_cache_cnt > 0)
+        t = thread_cache[--thread_cache_cnt];
+    spinlock_release(&thread_cache_lock);
+    intr_set_level(old_level);
+
+    return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Gives the page of dead thread T back to the cache, or to
+   palloc if the cache is full.  Interrupts must be off. */
+static void thread_page_free(struct thread *t) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    t->magic = 0;
+    spinlock_acquire(&thread_cache_lock);
+    if (thread_cache_enabled && thread_cache_cnt < THREAD_CACHE_MAX) {
+        thread_cache[thread_cache_cnt++] = t;
+        t = NULL;
+    }
+    spinlock_release(&thread_cache_lock);
+
+    if (t != NULL)
+        palloc_free_page(t);
+}
+
+/* Enables or disables the cache of dead threads' pages.
+   Disabling it also empties it.  For benchmarks. */
+void thread_cache_enable(bool enable) {
+    enum intr_level old_level = intr_disable();
+    void *pages[THREAD_CACHE_MAX];
+    int cnt;
+
+    spinlock_acquire(&thread_cache_lock);
+    thread_cache_enabled = enable;
+    cnt = enable ? 0 : thread_cache_cnt;
+    memcpy(pages, thread_cache, cnt * sizeof *pages);
+    thread_cache_cnt -= cnt;
+    spinlock_release(&thread_cache_lock);
+
+    while (cnt > 0) palloc_free_page(pages[--cnt]);
+    intr_set_level(old_level);
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t allocate_tid(void) {
     static tid_t next_tid = 1;
@@ -638,32 +949,36 @@ static tid_t allocate_tid(void) {
     return tid;
 }
 
+/* Timer callback that wakes up the thread sleeping in
+   thread_sleep().  Runs in the timer interrupt handler. */
+static void thread_sleep_expired(void *t_) {
+    struct thread *t = t_;
+
+    t->wake_time = -1;
+    thread_unblock(t);
+    if (t->priority > thread_current()->priority)
+        intr_yield_on_return();
+}
+
+/* Blocks the running thread until timer_ticks() reaches
+   WAKE_TIME. */
 void thread_sleep(int64_t wake_time) {
+    struct timer_event wakeup;
     enum intr_level old_level;
     struct thread *curr;
 
     old_level = intr_disable();
     curr = thread_current();
 
-    //    curr->status = THREAD_BLOCKED;
     curr->wake_time = wake_time;
-    list_insert_ordered(&sleep_list, &curr->elem, wake_early, NULL);
+    trace(TRACE_SLEEP, curr->tid, wake_time - timer_ticks());
+    timer_event_init(&wakeup, thread_sleep_expired, curr);
+    timer_event_add(&wakeup, wake_time);
     thread_block();
 
     intr_set_level(old_level);
 }
 
-/* Returns true if value A is less than value B, false
-   otherwise. */
-bool wake_early(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
-    const struct thread *a = list_entry(a_, struct thread, elem);
-    const struct thread *b = list_entry(b_, struct thread, elem);
-
-    if (a->wake_time == b->wake_time)
-        return a->priority > b->priority;
-    return a->wake_time < b->wake_time;
-}
-
 bool higher_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
     const struct thread *a = list_entry(a_, struct thread, elem);
     const struct thread *b = list_entry(b_, struct thread, elem);
@@ -678,17 +993,6 @@ bool lower_priority(const struct list_elem *a_, const struct list_elem *b_, void
     return a->priority < b->priority;
 }
 
-void thread_awake() {
-    int64_t now = timer_ticks();
-
-    while (!list_empty(&sleep_list) &&
-           list_entry(list_front(&sleep_list), struct thread, elem)->wake_time <= now) {
-        struct thread *wake = list_entry(list_pop_front(&sleep_list), struct thread, elem);
-        wake->wake_time = -1;
-        thread_unblock(wake);
-    }
-}
-
 int get_high_donation(struct thread *t) {
     return list_entry(list_back(&t->donation_list), struct thread, donation_elem)->priority;
 }
@@ -712,13 +1016,14 @@ void set_donations_priority(struct thread *holder) {
         holder = holder->wait_on_lock->holder;
         if (holder->priority >= priority_to_donate)
             break;
-        holder->priority = priority_to_donate;
+        trace(TRACE_DONATE, holder->tid, priority_to_donate);
+        thread_change_priority(holder, priority_to_donate);
     }
 }
 
 // ================추가함수
 void thread_try_yield(void) {
-    if (!list_empty(&ready_list) && thread_current() != idle_thread && !(intr_context()))
+    if (ready_mask != 0 && thread_current() != idle_thread && !(intr_context()))
         thread_yield();
 }
 // ================
@@ -0,0 +1,89 @@
+#include "threads/trace.h"
+
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+/* Number of events kept.  Must be a power of 2. */
+#define TRACE_SIZE 4096
+
+/* A recorded event. */
+struct trace_event {
+    uint64_t tsc;  /* Time stamp counter when recorded. */
+    int32_t tid;   /* Thread the event concerns. */
+    int32_t arg;   /* Event-specific argument. */
+    uint8_t type;  /* An enum trace_type. */
+};
+
+/* If true, record events.  Set by kernel command-line option
+   "-trace". */
+bool trace_enabled;
+
+/* Ring buffer.  trace_head counts every event ever recorded; the
+   slot for an event is its count modulo TRACE_SIZE.  Each writer
+   claims its slot with an atomic increment, so an interrupt
+   handler that preempts a writer never shares its slot. */
+static struct trace_event trace_buf[TRACE_SIZE];
+static uint32_t trace_head;
+
+/* TSC and timer ticks at trace_init(), for estimating the TSC
+   frequency at dump time. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+static const char *trace_names[] = {
+    [TRACE_SCHEDULE] = "schedule", [TRACE_UNBLOCK] = "unblock", [TRACE_DONATE] = "donate",
+    [TRACE_SLEEP] = "sleep",       [TRACE_TICK] = "tick",
+};
+
+/* Notes the starting point for TSC frequency estimation.  Must
+   be called after the timer is running. */
+void trace_init(void) {
+    start_ticks = timer_ticks();
+    start_tsc = rdtsc();
+}
+
+/* Records an event of TYPE about thread TID with argument ARG. */
+void trace_record(enum trace_type type, int tid, int arg) {
+    uint32_t slot = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    struct trace_event *e = &trace_buf[slot % TRACE_SIZE];
+
+    e->tsc = rdtsc();
+    e->tid = tid;
+    e->arg = arg;
+    e->type = type;
+}
+
+/* Prints the recorded events, oldest first, as CSV lines
+   "tsc,event,tid,arg" between a header giving the event
+   count and TSC frequency and a trailer.  TSC values are
+   relative to the oldest event.  Stops recording first, so that
+   the dump does not overwrite itself. */
+void trace_dump(void) {
+    uint32_t head, first, i;
+    uint64_t base, hz = 0;
+    int64_t elapsed;
+
+    if (!trace_enabled)
+        return;
+    trace_enabled = false;
+
+    elapsed = timer_ticks() - start_ticks;
+    if (start_tsc != 0 && elapsed > 0)
+        hz = (rdtsc() - start_tsc) / elapsed * TIMER_FREQ;
+
+    head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    first = head > TRACE_SIZE ? head - TRACE_SIZE : 0;
+    base = head > 0 ? trace_buf[first % TRACE_SIZE].tsc : 0;
+
+    printf("trace: begin %" PRIu32 " events, %" PRIu32 " dropped, %" PRIu64 " tsc hz\n",
+           head - first, first, hz);
+    for (i = first; i != head; i++) {
+        const struct trace_event *e = &trace_buf[i % TRACE_SIZE];
+        printf("%" PRIu64 ",%s,%d,%d\n", e->tsc - base, trace_names[e->type], e->tid, e->arg);
+    }
+    printf("trace: end\n");
+}
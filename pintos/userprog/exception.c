@@ -6,7 +6,10 @@
 #include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -144,6 +147,13 @@ static void page_fault(struct intr_frame *f) {
     else {
         exit(-1);
     }
+#else
+    /* fork()가 공유한 페이지에 처음 쓰는 경우 */
+    if (!not_present && write && process_cow_fault(fault_addr))
+        return;
+    /* CR0.WP가 켜져 있어서, 시스템 콜이 읽기 전용 사용자 페이지에 쓰면 여기로 온다. */
+    if (!user && write && is_user_vaddr(fault_addr))
+        exit(-1);
 #endif
 
     /* Count page faults. */
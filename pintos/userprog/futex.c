@@ -0,0 +1,169 @@
+#include "userprog/futex.h"
+
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* Futexes ("fast user-space mutexes").
+
+   A user program blocks on a 32-bit word of its memory with
+   futex_wait() and is woken by futex_wake() on the same word, so
+   that user-level locks only enter the kernel when they actually
+   have to wait.  A futex word in a file mapping, which other
+   processes may map too, is identified by the file's inode and the
+   word's offset in the file, so that a process can wake waiters in
+   any process that shares the mapping.  A word anywhere else is
+   private to its process and is identified by the address space
+   and its virtual address, (pml4, va).
+
+   Waiters are kept in a fixed-size hash table of lists, so that
+   waiting never needs to allocate memory.  The table is shared
+   with the timer interrupt handler, which removes waiters whose
+   timeout expires, so it is protected by disabling interrupts. */
+
+#define FUTEX_BUCKETS 64
+static struct list futex_buckets[FUTEX_BUCKETS];
+
+/* Identifies a futex word. */
+struct futex_key {
+    const void *object; /* Inode of a file mapping, or pml4. */
+    uint64_t offset;    /* Offset in the file, or virtual address. */
+};
+
+/* A thread blocked in futex_wait().  Lives on its stack. */
+struct futex_waiter {
+    struct list_elem elem;      /* Element in a futex bucket. */
+    struct futex_key key;       /* The futex word. */
+    struct thread *thread;      /* The waiting thread. */
+    bool woken;                 /* Woken by futex_wake()? */
+    struct timer_event timeout; /* Expires the wait. */
+};
+
+/* Returns the key of the futex word at UADDR in the running
+   process.  The word's page must have been touched, so that a
+   file page knows its place in the file. */
+static struct futex_key futex_key_of(uint32_t *uaddr) {
+    struct thread *curr = thread_current();
+#ifdef VM
+    struct page *page = spt_lookup_page(&curr->spt, uaddr);
+
+    if (page != NULL && VM_TYPE(page->operations->type) == VM_FILE)
+        return (struct futex_key){file_get_inode(page->file.file), page->file.ofs + pg_ofs(uaddr)};
+#endif
+    return (struct futex_key){curr->pml4, (uint64_t)uaddr};
+}
+
+/* Returns true if keys A and B are the same. */
+static bool futex_key_equal(const struct futex_key *a, const struct futex_key *b) {
+    return a->object == b->object && a->offset == b->offset;
+}
+
+/* Returns the bucket for the futex with KEY. */
+static struct list *futex_bucket(const struct futex_key *key) {
+    return &futex_buckets[hash_bytes(key, sizeof *key) % FUTEX_BUCKETS];
+}
+
+/* Reads the futex word at UADDR, so that its page is brought in
+   by a page fault now, with interrupts on. */
+static void futex_touch(uint32_t *uaddr) {
+    (void)*(volatile uint32_t *)uaddr;
+}
+
+/* Initializes the futex table. */
+void futex_init(void) {
+    for (int i = 0; i < FUTEX_BUCKETS; i++) list_init(&futex_buckets[i]);
+}
+
+/* Timer callback that ends the wait of futex_waiter W_ when its
+   timeout expires.  Runs in the timer interrupt handler. */
+static void futex_timeout(void *w_) {
+    struct futex_waiter *w = w_;
+
+    list_remove(&w->elem);
+    thread_unblock(w->thread);
+}
+
+/* Blocks the running thread on the futex word at UADDR, which
+   must be a valid, 4-byte aligned user address, as long as it
+   holds EXPECTED.  If TIMEOUT is nonnegative, gives up after
+   that many timer ticks.  Returns FUTEX_WOKEN, FUTEX_AGAIN or
+   FUTEX_TIMEDOUT. */
+int futex_wait(uint32_t *uaddr, uint32_t expected, int64_t timeout) {
+    struct thread *curr = thread_current();
+    struct futex_waiter w;
+    enum intr_level old_level;
+    uint32_t *kaddr;
+
+    /* Read the word with interrupts on first, which brings its page
+       in.  The read that counts is the one with interrupts off, so
+       that no futex_wake() can come between it and our going to
+       sleep; it goes through the kernel mapping of the frame, so it
+       cannot fault.  If the page was evicted in between, bring it
+       in again. */
+    futex_touch(uaddr);
+    w.key = futex_key_of(uaddr);
+    for (;;) {
+        old_level = intr_disable();
+        kaddr = pml4_get_page(curr->pml4, uaddr);
+        if (kaddr != NULL)
+            break;
+        intr_set_level(old_level);
+        futex_touch(uaddr);
+    }
+    if (*(volatile uint32_t *)kaddr != expected) {
+        intr_set_level(old_level);
+        return FUTEX_AGAIN;
+    }
+
+    w.thread = curr;
+    w.woken = false;
+    list_push_back(futex_bucket(&w.key), &w.elem);
+    timer_event_init(&w.timeout, futex_timeout, &w);
+    if (timeout >= 0)
+        timer_event_add(&w.timeout, timer_ticks() + timeout);
+    thread_block();
+    intr_set_level(old_level);
+
+    return w.woken ? FUTEX_WOKEN : FUTEX_TIMEDOUT;
+}
+
+/* Wakes up at most N threads blocked on the futex word at UADDR
+   in the running process, or at the same place in the same file
+   in any process if the word is in a file mapping.  Returns the
+   number woken. */
+int futex_wake(uint32_t *uaddr, int n) {
+    struct futex_key key;
+    struct list *bucket;
+    enum intr_level old_level;
+    struct list_elem *e;
+    int woken = 0;
+
+    futex_touch(uaddr);
+    key = futex_key_of(uaddr);
+    bucket = futex_bucket(&key);
+    old_level = intr_disable();
+    for (e = list_begin(bucket); e != list_end(bucket) && woken < n;) {
+        struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+
+        if (futex_key_equal(&w->key, &key)) {
+            e = list_remove(e);
+            timer_event_cancel(&w->timeout);
+            w->woken = true;
+            thread_unblock(w->thread);
+            woken++;
+        } else
+            e = list_next(e);
+    }
+    intr_set_level(old_level);
+
+    return woken;
+}
@@ -14,6 +14,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
@@ -55,7 +56,7 @@ struct thread *get_child_with_pid(tid_t pid) {
 /* General process initializer for initd and other process. */
 static void process_init(void) {
     struct thread *current = thread_current();
-    lock_init(&exec_lock);
+    lock_init_named(&exec_lock, "exec");
 }
 
 /* Starts the first userland program, called "initd", loaded from FILE_NAME.
@@ -133,12 +134,115 @@ tid_t process_fork(const char *name, struct intr_frame *if_ UNUSED) {
 
 #ifndef VM
 
+/* Copy-on-write fork() without the VM subsystem.  fork() maps the
+ * parent's pages into the child instead of copying them.  Writable
+ * pages lose PTE_W in both processes and get PTE_COW instead, and
+ * process_cow_fault() copies them on the first write.  COW_REFS
+ * counts, for each page of the user pool, the mappings beyond the
+ * first, so that only the last process to unmap a page frees it. */
+#define PTE_COW 0x200 /* One of PTE_AVL: writable, but shared. */
+
+static uint16_t *cow_refs;
+static uint8_t *cow_base;
+static size_t cow_cnt;
+static struct lock cow_lock;
+
+/* Initializes copy-on-write reference counting. */
+void process_cow_init(void) {
+    void *base;
+
+    palloc_pool_range(PAL_USER, &base, &cow_cnt);
+    cow_base = base;
+    cow_refs = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+                                   DIV_ROUND_UP(cow_cnt * sizeof *cow_refs, PGSIZE));
+    lock_init_named(&cow_lock, "cow");
+}
+
+/* Returns the reference count of KPAGE, a page of the user pool. */
+static uint16_t *cow_ref(void *kpage) {
+    size_t idx = ((uint8_t *)kpage - cow_base) / PGSIZE;
+
+    ASSERT((uint8_t *)kpage >= cow_base && idx < cow_cnt);
+    return &cow_refs[idx];
+}
+
+/* Handles a write fault at ADDR on a page of the running process
+ * that fork() left shared.  Returns false if the fault is not of
+ * that kind, or if no page is left for the copy. */
+bool process_cow_fault(void *addr) {
+    struct thread *curr = thread_current();
+    void *upage = pg_round_down(addr);
+    uint64_t *pte;
+    uint16_t *ref;
+
+    if (curr->pml4 == NULL || !is_user_vaddr(addr))
+        return false;
+    pte = pml4e_walk(curr->pml4, (uint64_t)upage, false);
+    if (pte == NULL || (*pte & PTE_P) == 0 || (*pte & PTE_COW) == 0)
+        return false;
+
+    lock_acquire(&cow_lock);
+    ref = cow_ref(ptov(PTE_ADDR(*pte)));
+    if (*ref > 0) {
+        /* 아직 다른 프로세스와 공유 중이면 복사본을 만든다. */
+        void *newpage = palloc_get_page(PAL_USER);
+
+        if (newpage == NULL) {
+            lock_release(&cow_lock);
+            return false;
+        }
+        memcpy(newpage, ptov(PTE_ADDR(*pte)), PGSIZE);
+        (*ref)--;
+        *pte = vtop(newpage) | (*pte & PTE_FLAGS);
+    }
+    *pte = (*pte | PTE_W) & ~(uint64_t)PTE_COW;
+    lock_release(&cow_lock);
+
+    invlpg((uint64_t)upage);
+    return true;
+}
+
+/* Returns true if the running process has ADDR mapped, writable if
+ * WRITE is true.  A page fork() left shared counts as writable,
+ * since writing to it just takes a copy-on-write fault. */
+bool process_check_access(void *addr, bool write) {
+    struct thread *curr = thread_current();
+    uint64_t *pte;
+
+    if (curr->pml4 == NULL || !is_user_vaddr(addr))
+        return false;
+    pte = pml4e_walk(curr->pml4, (uint64_t)pg_round_down(addr), false);
+    if (pte == NULL || (*pte & PTE_P) == 0 || (*pte & PTE_U) == 0)
+        return false;
+    return !write || (*pte & (PTE_W | PTE_COW)) != 0;
+}
+
+/* pml4_for_each() callback for process_cleanup(): unmaps the pages
+ * other processes still share, so that pml4_destroy() leaves them
+ * alone. */
+static bool release_shared_pte(uint64_t *pte, void *va, void *aux UNUSED) {
+    uint16_t *ref;
+
+    if (is_kernel_vaddr(va))
+        return true;
+
+    lock_acquire(&cow_lock);
+    ref = cow_ref(ptov(PTE_ADDR(*pte)));
+    if (*ref > 0) {
+        (*ref)--;
+        *pte = 0;
+    }
+    lock_release(&cow_lock);
+    return true;
+}
+
+/* Shares the parent's page at VA with the child.  A writable page
+ * becomes read-only in both and is copied on the first write. */
 static bool duplicate_pte(uint64_t *pte, void *va, void *aux) {
     struct thread *current = thread_current();
     struct thread *parent = (struct thread *)aux;
     void *parent_page;
-    void *newpage;
-    bool writable;
+    uint64_t *child_pte;
 
     if (is_kernel_vaddr(va))
         return true;
@@ -149,20 +253,21 @@ static bool duplicate_pte(uint64_t *pte, void *va, void *aux) {
         return false;
     }
 
-    newpage = palloc_get_page(PAL_USER);
-    if (newpage == NULL) {
-        return false;
-    }
+    /* 부모는 fork() 안에서 기다리는 중이므로, 다시 돌 때 CR3를 새로
+     * 읽으면서 쓰기 가능했던 TLB 항목도 사라진다. */
+    if (is_writable(pte))
+        *pte = (*pte & ~(uint64_t)PTE_W) | PTE_COW;
 
-    memcpy(newpage, parent_page, PGSIZE);
-    writable = is_writable(pte);
-    /* 5. 새 페이지를 주소 VA에 WRITABLE 권한으로 자식의 페이지 테이블에 추가합니다. */
-    /* 5. Add new page to child's page table at address VA with WRITABLE
-     *    permission. */
-    if (!pml4_set_page(current->pml4, va, newpage, writable)) {
-        palloc_free_page(newpage);
+    /* 5. 같은 페이지를 읽기 전용으로 자식의 페이지 테이블에 추가합니다. */
+    if (!pml4_set_page(current->pml4, va, parent_page, false)) {
         return false;
     }
+    child_pte = pml4e_walk(current->pml4, (uint64_t)va, false);
+    *child_pte |= *pte & PTE_COW;
+
+    lock_acquire(&cow_lock);
+    (*cow_ref(parent_page))++;
+    lock_release(&cow_lock);
     return true;
 }
 #endif
@@ -203,12 +308,14 @@ static void __do_fork(void *aux) {
         succ = false;
         goto error;
     }
+    current->stack_bottom = parent->stack_bottom;
 #else
     /* 기본 페이징 시: 부모의 모든 페이지를 자식으로 복사 */
-    if (!pml4_for_each(parent->pml4, duplicate_pte, parent)) {
-        succ = false;
+    succ = pml4_for_each(parent->pml4, duplicate_pte, parent);
+    /* duplicate_pte가 부모의 PTE를 쓰기 금지했으니, 부모가 다시 돌 때 TLB를 비운다. */
+    pml4_flush(parent->pml4);
+    if (!succ)
         goto error;
-    }
 #endif
 
     /* 3. 파일 디스크립터 테이블(FDT) 복제 */
@@ -419,7 +526,7 @@ void process_exit(void) {
             file_close(curr->fdt[i]);
         }
     }
-    palloc_free_page(curr->fdt);  // fdt 메모리 해제
+    free(curr->fdt);  // fdt 메모리 해제
 
     if (curr->running_file != NULL) {
         // file_allow_write(curr->running_file);
@@ -459,6 +566,9 @@ static void process_cleanup(void) {
          * that's been freed (and cleared). */
         curr->pml4 = NULL;
         pml4_activate(NULL);
+#ifndef VM
+        pml4_for_each(pml4, release_shared_pte, NULL);
+#endif
         pml4_destroy(pml4);
     }
 }
@@ -826,37 +936,15 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     ASSERT(pg_ofs(upage) == 0);
     ASSERT(ofs % PGSIZE == 0);
 
-    while (read_bytes > 0 || zero_bytes > 0) {
-        /* Do calculate how to fill this page.
-         * We will read PAGE_READ_BYTES bytes from FILE
-         * and zero the final PAGE_ZERO_BYTES bytes. */
-        size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-        size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-        /* TODO: Set up aux to pass information to the lazy_load_segment. */
-        // struct lazy_segment_arg *aux = {file, ofs, page_read_bytes, page_zero_bytes};
-        struct lazy_segment_arg *aux = malloc(sizeof(struct lazy_segment_arg));
-
-        if (!aux)
-            return false;
-
-        aux->file = file;
-        aux->ofs = ofs;
-        aux->page_read_bytes = page_read_bytes;
-        aux->page_zero_bytes = page_zero_bytes;
-
-        if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux)) {
-            free(aux);
-            return false;
-        }
-
-        /* Advance. */
-        read_bytes -= page_read_bytes;
-        zero_bytes -= page_zero_bytes;
-        upage += PGSIZE;
-        ofs += page_read_bytes;
-    }
-    return true;
+    /* 페이지는 처음 fault가 날 때 영역에서 만들어진다.  읽기 전용 세그먼트는
+     * 실행 파일에 묶인 VM_FILE 페이지라서, 같은 ELF를 실행하는 프로세스끼리
+     * frame_cache로 프레임을 나눠 쓰고, 내보낼 때는 swap에 쓰지 않고 버린다.
+     * VM_MARKER_1은 munmap()으로 풀 수 없는 실행 파일 영역이라는 표시다. */
+    if (!writable)
+        return vma_map(&thread_current()->spt, upage, read_bytes + zero_bytes, false,
+                       VM_FILE | VM_MARKER_1, file, ofs, read_bytes, NULL);
+    return vma_map(&thread_current()->spt, upage, read_bytes + zero_bytes, true, VM_ANON, file,
+                   ofs, read_bytes, lazy_load_segment);
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
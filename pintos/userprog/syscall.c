@@ -17,6 +17,11 @@
 #include "filesys/filesys.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "userprog/futex.h"
+#include "userprog/process.h"
+#ifdef VM
+#include "vm/file.h"
+#endif
 
 #define STDIN_FILENO 0
 #define STDOUT_FILENO 1
@@ -26,6 +31,7 @@
 typedef int pid_t;
 
 static bool check_address(void *addr);
+static bool check_buffer(const void *buffer, unsigned size, bool write);
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
 
@@ -42,6 +48,12 @@ int open(const char *file_name);
 int filesize(int fd);
 int read(int fd, void *buffer, unsigned size);
 void close(int fd);
+#ifdef VM
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
+void munmap(void *addr);
+#endif
+int sys_futex_wait(uint32_t *uaddr, uint32_t expected, int64_t timeout);
+int sys_futex_wake(uint32_t *uaddr, int n);
 /* ======================================*/
 
 /* System call.
@@ -58,7 +70,10 @@ void close(int fd);
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
 /* ====== lock ====== */
-struct lock filesys_lock;
+/* Serializes file system calls.  open, filesize and read only
+   look things up and read, so they share it; create, remove and
+   write take it exclusively. */
+struct rwlock filesys_lock;
 
 void syscall_init(void) {
     write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 | ((uint64_t)SEL_KCSEG) << 32);
@@ -70,7 +85,8 @@ void syscall_init(void) {
     write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
     // lock init
-    lock_init(&filesys_lock);
+    rwlock_init_named(&filesys_lock, "filesys");
+    futex_init();
 }
 
 /* ====== 메인 시스템콜 인터페이스  => 커널공간 ===== */
@@ -79,6 +95,9 @@ void syscall_handler(struct intr_frame *f UNUSED) {
     // printf ("system call!\n");  //이부분 Test때는 주석처리
 
     int syscall_number = f->R.rax;  // 시스템 콜 번호는 rax 레지스터에 저장됨
+#ifdef VM
+    thread_current()->rsp_stack = (void *)f->rsp;
+#endif
     switch (syscall_number) {       // rdi -> rsi -> rdx -> r10 .....
         case SYS_HALT:              // case : 0
             halt();
@@ -122,6 +141,23 @@ void syscall_handler(struct intr_frame *f UNUSED) {
         case SYS_CLOSE:  // case : 13
             close(f->R.rdi);
             break;
+#ifdef VM
+        case SYS_MMAP:
+            f->R.rax = (uint64_t)mmap((void *)f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8);
+            break;
+        case SYS_MUNMAP:
+            munmap((void *)f->R.rdi);
+            break;
+#endif
+        case SYS_FUTEX_WAIT:
+            f->R.rax = sys_futex_wait((uint32_t *)f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+        case SYS_FUTEX_WAKE:
+            f->R.rax = sys_futex_wake((uint32_t *)f->R.rdi, f->R.rsi);
+            break;
+        case SYS_YIELD:
+            thread_yield();
+            break;
         // case SYS_DUP2:
         //     f->R.rax = dup2 (f->R.rdi, f->R.rsi);
         //     break;
@@ -143,6 +179,14 @@ void exit(int status) {  // Case : 1
 
     struct thread *cur = thread_current();
     cur->exit_status = status;  // 나의 exit 상태 기록
+
+    /* 파일 시스템 작업 도중 page fault로 죽으면 락을 놓고 가야 다른 프로세스가 멈추지 않는다. */
+    if (rwlock_held_by_current_thread(&filesys_lock)) {
+        if (filesys_lock.writer == cur)
+            rwlock_release_write(&filesys_lock);
+        else
+            rwlock_release_read(&filesys_lock);
+    }
     printf("%s: exit(%d)\n", cur->name, status);
     thread_exit();
 }
@@ -235,9 +279,9 @@ bool create(const char *file, unsigned initial_size) {  // Case : 5
         exit(-1);
     }
     // filesys.c 에 정의된 함수 사용
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     success = filesys_create(file, initial_size);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
 
     return success;
 }
@@ -248,9 +292,9 @@ bool remove(const char *file) {  // Case : 6 -> 일단 간단한 버전
         exit(-1);
     }
     // filesys.c 에 정의된 함수 사용
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     success = filesys_remove(file);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
 
     return success;
 }
@@ -270,9 +314,9 @@ int open(const char *file_name) {  // Case : 7
     strlcpy(file_name_copy, file_name, PGSIZE);
 
     // 파일 열기
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_read(&filesys_lock);
     struct file *file_ptr = filesys_open(file_name_copy);
-    lock_release(&filesys_lock);
+    rwlock_release_read(&filesys_lock);
     palloc_free_page(file_name_copy);
 
     if (file_ptr == NULL) {
@@ -324,9 +368,9 @@ int filesize(int fd) {  // Case : 8 -> read()에서 호출
     }
 
     // file.c
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_read(&filesys_lock);
     size = file_length(cur_file);
-    lock_release(&filesys_lock);
+    rwlock_release_read(&filesys_lock);
 
     return size;
 }
@@ -341,6 +385,11 @@ int read(int fd, void *buffer, unsigned size) {  // Case : 9
         exit(-1);
     }
 
+    // 락을 잡은 채 버퍼에서 fault가 나 죽지 않도록, 버퍼 전체에 쓸 수 있는지 미리 확인
+    if (!check_buffer(buffer, size, true)) {
+        exit(-1);
+    }
+
     // read-bad-fd.c : fd 범위 벗어나는지 체크
     if (fd < 0 || fd >= FDT_MAX_SIZE) {
         exit(-1);
@@ -379,21 +428,21 @@ int read(int fd, void *buffer, unsigned size) {  // Case : 9
         }
 
         // 동시접근 막기위한 락 획득
-        lock_acquire(&filesys_lock);
+        rwlock_acquire_read(&filesys_lock);
 
         // file.c 의 file_read 사용
         bytes_read = file_read(cur_file, buffer, size);
 
         // 락 해제
-        lock_release(&filesys_lock);
+        rwlock_release_read(&filesys_lock);
     }
 
     return bytes_read;
 }
 
 int write(int fd, const void *buffer, unsigned size) {  // Case : 10
-    // 버퍼 주소 유효성 검사
-    if (!check_address(buffer)) {
+    // 버퍼 주소 유효성 검사 (버퍼 전체를 읽을 수 있어야 함)
+    if (!check_address(buffer) || !check_buffer(buffer, size, false)) {
         exit(-1);
     }
 
@@ -433,10 +482,17 @@ int write(int fd, const void *buffer, unsigned size) {  // Case : 10
             return -1;
         }
 
-        lock_acquire(&filesys_lock);
+        rwlock_acquire_write(&filesys_lock);
+#ifdef VM
+        off_t ofs = file_tell(file_obj);
+#endif
         // file_write는 파일 끝까지만 쓰고 실제 쓰여진 바이트 수를 반환
         bytes_written = file_write(file_obj, buffer, size);
-        lock_release(&filesys_lock);
+#ifdef VM
+        // 공유 중인 읽기 전용 파일 프레임이 옛 내용을 계속 내주지 않도록 한다.
+        vm_invalidate_file_frames(file_get_inode(file_obj), ofs, bytes_written);
+#endif
+        rwlock_release_write(&filesys_lock);
     }
     return bytes_written;
 }
@@ -461,6 +517,42 @@ void close(int fd) {  // Case : 13
     cur->fdt[fd] = NULL;
 }
 
+#ifdef VM
+/* fd의 파일을 ADDR에 매핑한다. 실패하면 NULL (MAP_FAILED) */
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
+    struct file *file;
+
+    // 표준 입출력과 범위 밖 fd는 매핑할 수 없음
+    if (fd <= 1 || fd >= FDT_MAX_SIZE) {
+        return NULL;
+    }
+    file = thread_current()->fdt[fd];
+    if (file == NULL) {
+        return NULL;
+    }
+    return do_mmap(addr, length, writable, file, offset);
+}
+
+void munmap(void *addr) {
+    do_munmap(addr);
+}
+#endif
+
+/* Futex 시스템콜: 주소 검증 후 userprog/futex.c 로 넘김 */
+int sys_futex_wait(uint32_t *uaddr, uint32_t expected, int64_t timeout) {
+    if (!check_address(uaddr) || (uintptr_t)uaddr % sizeof *uaddr != 0) {
+        exit(-1);
+    }
+    return futex_wait(uaddr, expected, timeout);
+}
+
+int sys_futex_wake(uint32_t *uaddr, int n) {
+    if (!check_address(uaddr) || (uintptr_t)uaddr % sizeof *uaddr != 0) {
+        exit(-1);
+    }
+    return futex_wake(uaddr, n);
+}
+
 //////////////////////////////////////////////////////////////////
 // 07.23 추가 : 유효주소 검사하는 헬퍼 함수 => exec() 에서 사용
 static bool check_address(void *addr) {
@@ -486,4 +578,27 @@ static bool check_address(void *addr) {
     }
 #endif
     return true;
-}
\ No newline at end of file
+}
+
+/* Returns true if every page of the SIZE bytes at BUFFER is user
+   memory the process may read, and write too if WRITE is true.
+   read() and write() check this before taking filesys_lock or the
+   console lock, so that a bad buffer ends the process before it
+   holds either. */
+static bool check_buffer(const void *buffer, unsigned size, bool write) {
+    const uint8_t *start = buffer, *end = start + size;
+
+    if (end < start)
+        return false;
+    for (const uint8_t *p = pg_round_down(start); p < end; p += PGSIZE) {
+        void *addr = (void *)(p < start ? start : p);
+#ifdef VM
+        if (!vm_check_access(addr, write))
+            return false;
+#else
+        if (!process_check_access(addr, write))
+            return false;
+#endif
+    }
+    return true;
+}
@@ -1,16 +1,28 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <stdio.h>
+#include <string.h>
+
 #include "devices/disk.h"
 #include "lib/kernel/bitmap.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "vm/vm.h"
 #include "vm/vm_enum.h"
+#include "vm/zswap.h"
 #ifndef BLOCK_SECTOR_SIZE
 #define BLOCK_SECTOR_SIZE 512
 #endif
+#define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
+
 static struct bitmap *swap_table;
 static struct lock swap_lock;
+
+/* Statistics. */
+static long long swap_out_cnt;      /* Pages written to swap. */
+static long long swap_write_cmds;   /* Disk commands used to write them. */
+static long long swap_in_cnt;       /* Pages read back from swap. */
+static long long swap_prefetch_cnt; /* Of those, pages read ahead of a fault. */
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
 static bool anon_swap_in(struct page *page, void *kva);
@@ -42,12 +54,13 @@ void vm_anon_init(void) {
 
     // 슬롯 개수 배열 만들기
     swap_table = bitmap_create(slot_cnt);
-    if (swap_table == NULL) {
+    if (swap_table == NULL || !bitmap_enable_summary(swap_table)) {
         PANIC("Failed to create swap bitmap");
     }
 
     bitmap_set_all(swap_table, false);
-    lock_init(&swap_lock);
+    lock_init_named(&swap_lock, "swap");
+    zswap_init();
 }
 
 /* Initialize the file mapping */
@@ -62,20 +75,196 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
 
     // slot 초가화
     anon_page->swap_slot = SIZE_MAX;
+    anon_page->zentry = NULL;
+
+    /* 새로 잡은 프레임에는 이전 주인의 내용이 남아 있을 수 있다. */
+    if (kva != NULL)
+        memset(kva, 0, PGSIZE);
+    return true;
+}
+
+/* Sorts the CNT pages in PAGES by owner, then by address, so that
+ * neighboring virtual pages of a process land in neighboring swap
+ * slots. */
+static void sort_pages(struct page *pages[], size_t cnt) {
+    for (size_t i = 1; i < cnt; i++) {
+        struct page *p = pages[i];
+        size_t j = i;
+
+        for (; j > 0; j--) {
+            struct page *q = pages[j - 1];
+            if (q->owner < p->owner || (q->owner == p->owner && q->va < p->va))
+                break;
+            pages[j] = q;
+        }
+        pages[j] = p;
+    }
+}
+
+/* Writes the CNT pages at KVAS to the CNT swap slots starting at
+ * SLOT, in one disk command, and stores their numbers in SLOTS. */
+static void write_slots(size_t slot, void *const kvas[], size_t cnt, size_t slots[]) {
+    const void *sectors[SWAP_CLUSTER * SECTORS_PER_PAGE];
+
+    ASSERT(cnt <= SWAP_CLUSTER);
+    for (size_t i = 0; i < cnt; i++) {
+        for (size_t j = 0; j < SECTORS_PER_PAGE; j++)
+            sectors[i * SECTORS_PER_PAGE + j] = (uint8_t *)kvas[i] + j * BLOCK_SECTOR_SIZE;
+        slots[i] = slot + i;
+    }
+    disk_write_multiple(swap_disk, slot * SECTORS_PER_PAGE, cnt * SECTORS_PER_PAGE, sectors);
+    swap_write_cmds++;
+}
+
+/* Writes the CNT pages at KVAS to runs of contiguous swap slots
+ * with as few disk commands as possible, and stores the slot of
+ * each in SLOTS.  The caller hands the slots to the pages, or
+ * gives them back with anon_free_slot().  Returns false if the
+ * swap disk is full. */
+bool anon_write_swap(void *const kvas[], size_t cnt, size_t slots[]) {
+    size_t done = 0;
+
+    ASSERT(cnt <= SWAP_CLUSTER);
+    while (done < cnt) {
+        size_t run = cnt - done;
+        size_t slot;
+
+        /* 연속된 슬롯이 모자라면 반씩 나눠서 쓴다. */
+        lock_acquire(&swap_lock);
+        while ((slot = bitmap_scan_and_flip(swap_table, 0, run, false)) == BITMAP_ERROR && run > 1)
+            run /= 2;
+        lock_release(&swap_lock);
+        if (slot == BITMAP_ERROR)
+            return false;
+
+        write_slots(slot, kvas + done, run, slots + done);
+        done += run;
+    }
+    swap_out_cnt += cnt;
+    return true;
+}
+
+/* Gives swap slot SLOT back. */
+void anon_free_slot(size_t slot) {
+    lock_acquire(&swap_lock);
+    bitmap_reset(swap_table, slot);
+    lock_release(&swap_lock);
+}
+
+/* Swaps out the CNT anonymous pages in PAGES, which must be
+ * resident and unmapped.  Pages that compress well go to the
+ * compressed store; the rest are written to the swap disk
+ * together.  The pages keep their frames; the caller takes them
+ * away.  Returns false if the swap disk is full. */
+bool anon_swap_out_cluster(struct page *pages[], size_t cnt) {
+    struct page *disk[SWAP_CLUSTER];
+    void *kvas[SWAP_CLUSTER];
+    size_t slots[SWAP_CLUSTER];
+    size_t disk_cnt = 0;
+
+    ASSERT(cnt <= SWAP_CLUSTER);
+    sort_pages(pages, cnt);
+    for (size_t i = 0; i < cnt; i++) {
+        if (zswap_store(pages[i]))
+            continue;
+        disk[disk_cnt] = pages[i];
+        kvas[disk_cnt++] = pages[i]->frame->kva;
+    }
+    if (disk_cnt > 0 && !anon_write_swap(kvas, disk_cnt, slots))
+        return false;
+    for (size_t i = 0; i < disk_cnt; i++) disk[i]->anon.swap_slot = slots[i];
+
+    zswap_shrink();
     return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Reads the contents of anonymous PAGE, which is in swap, into
+ * KVA, leaving its swap slot in place. */
+void anon_read_swap(struct page *page, void *kva) {
+    void *sectors[SECTORS_PER_PAGE];
+    size_t slot;
+
+    if (zswap_copy(page, kva))
+        return;
+
+    slot = page->anon.swap_slot;
+    ASSERT(slot != SIZE_MAX);
+    for (size_t j = 0; j < SECTORS_PER_PAGE; j++)
+        sectors[j] = (uint8_t *)kva + j * BLOCK_SECTOR_SIZE;
+    disk_read_multiple(swap_disk, slot * SECTORS_PER_PAGE, SECTORS_PER_PAGE, sectors);
+}
+
+/* Prints swap statistics. */
+void anon_print_stats(void) {
+    printf("Swap: %lld pages out in %lld writes, %lld pages in (%lld prefetched)\n",
+           swap_out_cnt, swap_write_cmds, swap_in_cnt, swap_prefetch_cnt);
+}
+
+/* Swap in the page by read contents from the swap disk.
+ * The following virtual pages of the same process, if their
+ * contents are in the following swap slots, are read in the same
+ * disk command and mapped too, as long as free frames last. */
 static bool anon_swap_in(struct page *page, void *kva) {
     struct anon_page *anon_page = &page->anon;
+    struct page *run[SWAP_CLUSTER];
+    struct frame *frames[SWAP_CLUSTER];
+    void *sectors[SWAP_CLUSTER * SECTORS_PER_PAGE];
+    size_t slot;
+    size_t cnt = 1;
+
+    if (zswap_load(page, kva))
+        return true;
+
+    slot = anon_page->swap_slot;
+    if (slot == SIZE_MAX) {
+        memset(kva, 0, PGSIZE);
+        return true;
+    }
+
+    run[0] = page;
+    frames[0] = page->frame;
+    while (cnt < SWAP_CLUSTER) {
+        struct page *next = spt_lookup_page(&page->owner->spt, (uint8_t *)page->va + cnt * PGSIZE);
+
+        if (next == NULL || next->frame != NULL || VM_TYPE(next->operations->type) != VM_ANON ||
+            next->anon.swap_slot != slot + cnt)
+            break;
+        frames[cnt] = vm_get_free_frame();
+        if (frames[cnt] == NULL)
+            break;
+        run[cnt++] = next;
+    }
+
+    for (size_t i = 0; i < cnt; i++)
+        for (size_t j = 0; j < SECTORS_PER_PAGE; j++)
+            sectors[i * SECTORS_PER_PAGE + j] = (uint8_t *)frames[i]->kva + j * BLOCK_SECTOR_SIZE;
+    disk_read_multiple(swap_disk, slot * SECTORS_PER_PAGE, cnt * SECTORS_PER_PAGE, sectors);
+
+    /* 매핑에 실패한 이웃 페이지는 슬롯을 그대로 둔다. */
+    for (size_t i = 0; i < cnt; i++) {
+        if (i > 0 && !vm_map_frame(run[i], frames[i]))
+            continue;
+        anon_free_slot(run[i]->anon.swap_slot);
+        run[i]->anon.swap_slot = SIZE_MAX;
+        swap_in_cnt++;
+        if (i > 0)
+            swap_prefetch_cnt++;
+    }
+    return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool anon_swap_out(struct page *page) {
-    struct anon_page *anon_page = &page->anon;
+    return anon_swap_out_cluster(&page, 1);
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void anon_destroy(struct page *page) {
     struct anon_page *anon_page = &page->anon;
+
+    zswap_drop(page);
+    if (anon_page->swap_slot != SIZE_MAX) {
+        anon_free_slot(anon_page->swap_slot);
+        anon_page->swap_slot = SIZE_MAX;
+    }
 }
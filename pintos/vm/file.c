@@ -1,5 +1,10 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
+#include <stdio.h>
+#include <string.h>
+
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
 #include "vm/vm.h"
 
 static bool file_backed_swap_in(struct page *page, void *kva);
@@ -14,34 +19,109 @@ static const struct page_operations file_ops = {
     .type = VM_FILE,
 };
 
+/* Statistics. */
+static long long read_cnt;  /* Pages read from files. */
+static long long write_cnt; /* Dirty pages written back. */
+
 /* The initializer of file vm */
 void vm_file_init(void) {}
 
-/* Initialize the file backed page */
-bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
+/* Initialize the file backed page.  Its place in the file comes from
+ * the VMA that contains it.  Reads the page into KVA unless KVA is
+ * null, which means the caller fills the frame itself. */
+bool file_backed_initializer(struct page *page, enum vm_type type UNUSED, void *kva) {
+    struct vma *vma = vma_find(&page->owner->spt, page->va);
+
     /* Set up the handler */
     page->operations = &file_ops;
 
-    struct file_page *file_page = &page->file;
+    if (vma == NULL || vma->file == NULL)
+        return false;
+    page->file = (struct file_page){
+        .file = vma->file,
+        .ofs = vma->ofs + ((uint8_t *)page->va - (uint8_t *)vma->start),
+        .read_bytes = vma_read_bytes(vma, page->va),
+    };
+    return kva == NULL || file_backed_swap_in(page, kva);
 }
 
 /* Swap in the page by read contents from the file. */
 static bool file_backed_swap_in(struct page *page, void *kva) {
-    struct file_page *file_page UNUSED = &page->file;
+    struct file_page *file_page = &page->file;
+
+    if (file_read_at(file_page->file, kva, file_page->read_bytes, file_page->ofs) !=
+        (off_t)file_page->read_bytes)
+        return false;
+    memset((uint8_t *)kva + file_page->read_bytes, 0, PGSIZE - file_page->read_bytes);
+    read_cnt++;
+    return true;
 }
 
-/* Swap out the page by writeback contents to the file. */
+/* Writes PAGE, which is resident, back to its file if the process
+ * wrote to it since it was mapped. */
+static void file_backed_write_back(struct page *page) {
+    struct file_page *file_page = &page->file;
+
+    if (!pml4_is_dirty(page->owner->pml4, page->va))
+        return;
+    file_write_at(file_page->file, page->frame->kva, file_page->read_bytes, file_page->ofs);
+    /* frame_cache에 든 프레임이면 방금 쓴 내용 그대로이므로 남겨 둔다. */
+    if (page->frame->inode == NULL)
+        vm_invalidate_file_frames(file_get_inode(file_page->file), file_page->ofs,
+                                  file_page->read_bytes);
+    pml4_set_dirty(page->owner->pml4, page->va, false);
+    write_cnt++;
+}
+
+/* Swap out the page by writeback contents to the file.  The page is
+ * already unmapped; its PTE still has the dirty bit. */
 static bool file_backed_swap_out(struct page *page) {
-    struct file_page *file_page UNUSED = &page->file;
+    file_backed_write_back(page);
+    return true;
 }
 
-/* Destory the file backed page. PAGE will be freed by the caller. */
+/* Destory the file backed page. PAGE will be freed by the caller.
+ * Its frame is normally released, and a dirty page written back,
+ * before this is called; a page that still has one is written back
+ * here. */
 static void file_backed_destroy(struct page *page) {
-    struct file_page *file_page UNUSED = &page->file;
+    if (page->frame != NULL && page->owner->pml4 != NULL)
+        file_backed_write_back(page);
 }
 
 /* Do the mmap */
-void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset) {}
+void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset) {
+    uint8_t *end = (uint8_t *)addr + length;
+    off_t size = file_length(file);
+    size_t read_bytes;
+
+    if (addr == NULL || pg_ofs(addr) != 0 || length == 0 || end < (uint8_t *)addr ||
+        !is_user_vaddr(addr) || !is_user_vaddr(end - 1))
+        return NULL;
+    if (offset < 0 || offset % PGSIZE != 0 || size == 0)
+        return NULL;
+
+    read_bytes = offset >= size ? 0 : (size_t)(size - offset) < length ? (size_t)(size - offset)
+                                                                        : length;
+    if (!vma_map(&thread_current()->spt, addr, length, writable, VM_FILE, file, offset,
+                 read_bytes, NULL))
+        return NULL;
+    return addr;
+}
 
 /* Do the munmap */
-void do_munmap(void *addr) {}
+void do_munmap(void *addr) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    struct vma *vma = vma_find(spt, addr);
+
+    /* mmap()이 돌려준 주소로만 해제할 수 있다. */
+    if (vma == NULL || vma->start != addr || VM_TYPE(vma->type) != VM_FILE ||
+        (vma->type & VM_MARKER_1))
+        return;
+    vma_unmap(spt, vma);
+}
+
+/* Prints file-backed page statistics. */
+void file_print_stats(void) {
+    printf("File-backed pages: %lld read, %lld written back\n", read_cnt, write_cnt);
+}
@@ -10,6 +10,7 @@
 
 #include "vm/uninit.h"
 
+#include "threads/malloc.h"
 #include "vm/vm.h"
 
 static bool uninit_initialize(struct page *page, void *kva);
@@ -60,7 +61,9 @@ static bool uninit_initialize(struct page *page, void *kva) {
  * exit, which are never referenced during the execution.
  * PAGE will be freed by the caller. */
 static void uninit_destroy(struct page *page) {
-    struct uninit_page *uninit UNUSED = &page->uninit;
-    /* TODO: Fill this function.
-     * TODO: If you don't have anything to do, just return. */
+    struct uninit_page *uninit = &page->uninit;
+
+    /* 초기화된 적이 없으니 lazy_load_segment가 놓았을 aux를 여기서 놓는다.
+     * spt_find_page가 VMA에서 만들기만 하고 쓰지 않은 페이지도 여기로 온다. */
+    free(uninit->aux);
 }
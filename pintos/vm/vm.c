@@ -3,23 +3,79 @@
 #include "vm/vm.h"
 
 #include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
 
 #include "devices/disk.h"
+#include "devices/timer.h"
+#include "filesys/inode.h"
 #include "kernel/hash.h"
 #include "kernel/list.h"
 #include "string.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/slab.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "vm/anon.h"
 #include "vm/file.h"
 #include "vm/inspect.h"
 #include "vm/uninit.h"
+#include "vm/zswap.h"
 
-static struct list frame_table;
+/* Frame table: one `struct frame' per page of the user pool. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static uint8_t *frame_base;
 static struct lock frame_table_lock;
-static struct list_elem *clock_hand = NULL;
+
+/* Signalled, under frame_table_lock, whenever a frame is unpinned
+ * or a page leaves its frame. */
+static struct condition frame_unpinned;
+
+/* Two-handed clock.  The front hand runs HAND_SPREAD frames ahead
+ * of CLOCK_HAND, the eviction hand, clearing accessed bits.  A
+ * frame is evicted if it has not been accessed again by the time
+ * the eviction hand reaches it. */
+static size_t clock_hand;
+static size_t hand_spread;
+
+/* Statistics. */
+static long long fault_cnt;    /* Calls to vm_try_handle_fault(). */
+static long long evict_cnt;    /* Frames evicted. */
+static long long share_cnt;    /* Pages shared copy-on-write by fork(). */
+static long long cow_copy_cnt; /* Shared pages copied on write. */
+static long long around_cnt;   /* File pages mapped around a fault. */
+static long long cached_cnt;   /* File pages mapped from frame_cache. */
+
+/* File pages in frames, by inode and offset. */
+static struct hash frame_cache;
+
+/* Pages mapped around a file-backed fault, aligned. */
+#define FAULT_AROUND 16
+
+/* How far user stacks may grow below USER_STACK, in bytes. */
+size_t vm_stack_max = 1024 * 1024;
+
+/* Stack pages claimed right above a stack growth fault. */
+#define STACK_PREFAULT 16
+
+static long long stack_grow_cnt; /* Stack pages added. */
+static size_t stack_deepest;     /* Deepest stack of any process. */
+
+/* A page of zeros, never written, that zero-fill pages are mapped
+ * to read-only until they are first written.  It is not a user
+ * frame: it is never evicted or freed. */
+static void *zero_kva;
+static long long zero_map_cnt; /* Read faults served by zero_kva. */
+
+/* Cache of `struct page's. */
+static struct kmem_cache *page_cache;
+
+static void inspect_vm_stat(struct intr_frame *);
+static hash_hash_func frame_cache_hash;
+static hash_less_func frame_cache_less;
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -34,9 +90,24 @@ void vm_init(void) {
     /* DO NOT MODIFY UPPER LINES. */
     /* TODO: Your code goes here. */
 
-    list_init(&frame_table);
-    lock_init(&frame_table_lock);
-    clock_hand = NULL;
+    void *base;
+    palloc_pool_range(PAL_USER, &base, &frame_cnt);
+    frame_base = base;
+    frame_table = palloc_get_multiple(PAL_ASSERT,
+                                      DIV_ROUND_UP(frame_cnt * sizeof *frame_table, PGSIZE));
+    for (size_t i = 0; i < frame_cnt; i++)
+        frame_table[i] = (struct frame){.kva = frame_base + i * PGSIZE};
+    lock_init_named(&frame_table_lock, "frame table");
+    cond_init(&frame_unpinned);
+    hash_init(&frame_cache, frame_cache_hash, frame_cache_less, NULL);
+    zero_kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+    clock_hand = 0;
+    hand_spread = frame_cnt / 4 > 0 ? frame_cnt / 4 : 1;
+
+    page_cache = kmem_cache_create("page", sizeof(struct page), NULL);
+    if (page_cache == NULL)
+        PANIC("cannot create page cache");
+    intr_register_int(0x45, 3, INTR_OFF, inspect_vm_stat, "Inspect VM Statistics");
     // disk_init();  // vm_anon_init()에서 swap 영역 지정할 때 사용하기 위해서 여기서 초기화함
 }
 
@@ -54,9 +125,12 @@ enum vm_type page_get_type(struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim(void);
 static bool vm_do_claim_page(struct page *page);
+static bool vm_claim_frame(struct page *page, bool evict);
 static struct frame *vm_evict_frame(void);
+static bool vm_copy_page(struct page *child, struct page *parent);
+static void vm_fault_around(struct page *page);
+static void vm_release_frame(struct page *page);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -68,14 +142,16 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
     struct supplemental_page_table *spt = &thread_current()->spt;
 
     /* Check wheter the upage is already occupied or not. */
-    if (spt_find_page(spt, upage) == NULL) {
+    if (spt_lookup_page(spt, upage) == NULL) {
         /* TODO: Create the page, fetch the initialier according to the VM type,
          * TODO: and then create "uninit" page struct by calling uninit_new. You
          * TODO: should modify the field after calling the uninit_new. */
         // anon_initializer -> 익명 페이지 1
         // uninit_initialize -> 0
         // file_backed_initializer -> 2
-        struct page *p = (struct page *)malloc(sizeof(struct page));
+        struct page *p = kmem_cache_alloc(page_cache);
+        if (p == NULL)
+            goto err;
 
         p->va = upage;
 
@@ -107,10 +183,20 @@ err:
     return false;
 }
 
-/* Find VA from spt and return page. On error, return NULL. */
+/* Find VA from spt and return page. On error, return NULL.  A page
+ * of the running process's VMAs that does not exist yet is created
+ * here. */
 struct page *spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-    struct page *page = NULL;
+    struct page *page = spt_lookup_page(spt, va);
+    struct vma *vma;
+
+    if (page == NULL && spt == &thread_current()->spt && (vma = vma_find(spt, va)) != NULL)
+        page = vma_create_page(vma, pg_round_down(va));
+    return page;
+}
 
+/* Like spt_find_page(), but never creates a page from a VMA. */
+struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va) {
     if (va == NULL || spt == NULL) {
         return NULL;
     }
@@ -131,7 +217,7 @@ bool spt_insert_page(struct supplemental_page_table *spt UNUSED, struct page *pa
         return false;
     }
 
-    if (spt_find_page(spt, page->va) != NULL) {
+    if (spt_lookup_page(spt, page->va) != NULL) {
         return false;
     }
     /**
@@ -147,103 +233,469 @@ void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
         return;
     }
     hash_delete(&spt->spt_hash, &page->hash_elem);
+    vm_release_frame(page);
     vm_dealloc_page(page);
 }
 
-// 시계 방향으로 돌기 위함
-void advance_clock_hand() {
-    clock_hand = list_next(clock_hand);
-    if (clock_hand == list_end(&frame_table)) {
-        clock_hand = list_begin(&frame_table);
+/* Returns the frame table entry for KVA, a page of the user pool. */
+struct frame *vm_frame_of(void *kva) {
+    size_t idx = ((uint8_t *)kva - frame_base) / PGSIZE;
+
+    ASSERT(pg_ofs(kva) == 0);
+    ASSERT((uint8_t *)kva >= frame_base && idx < frame_cnt);
+    return &frame_table[idx];
+}
+
+/* Adds PAGE to the pages sharing FRAME.  The caller must hold
+ * frame_table_lock or have FRAME pinned. */
+static void frame_link(struct frame *frame, struct page *page) {
+    page->frame = frame;
+    page->next_sharer = frame->page;
+    frame->page = page;
+}
+
+/* Removes PAGE from the pages sharing FRAME.  The last page out
+ * takes FRAME out of frame_cache. */
+static void frame_unlink(struct frame *frame, struct page *page) {
+    struct page **p = &frame->page;
+
+    while (*p != page) p = &(*p)->next_sharer;
+    *p = page->next_sharer;
+    page->frame = NULL;
+    page->next_sharer = NULL;
+
+    if (frame->page == NULL && frame->inode != NULL) {
+        hash_delete(&frame_cache, &frame->cache_elem);
+        frame->inode = NULL;
     }
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *vm_get_victim(void) {
-    struct frame *victim = NULL;
+static uint64_t frame_cache_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct frame *f = hash_entry(e, struct frame, cache_elem);
+
+    return hash_bytes(&f->inode, sizeof f->inode) ^ hash_int(f->ofs);
+}
+
+static bool frame_cache_less(const struct hash_elem *a_, const struct hash_elem *b_,
+                             void *aux UNUSED) {
+    const struct frame *a = hash_entry(a_, struct frame, cache_elem);
+    const struct frame *b = hash_entry(b_, struct frame, cache_elem);
+
+    if (a->inode != b->inode)
+        return a->inode < b->inode;
+    return a->ofs < b->ofs;
+}
+
+/* Returns true if FRAME, in frame_cache, is mapped writable by any
+ * of the pages sharing it.  The caller must hold frame_table_lock. */
+static bool frame_has_writer(const struct frame *frame) {
+    for (struct page *p = frame->page; p != NULL; p = p->next_sharer)
+        if (p->writable)
+            return true;
+    return false;
+}
+
+/* Enters FRAME, which holds PAGE, a file page, in frame_cache,
+ * unless another frame already holds the same file page.  A
+ * writable mapping of a file that is being run keeps its frame to
+ * itself, so that the program's code never shares it. */
+static void frame_cache_insert(struct frame *frame, struct page *page) {
+    if (page->writable && inode_is_write_denied(file_get_inode(page->file.file)))
+        return;
+    ASSERT(page->file.ofs % PGSIZE == 0);
 
     lock_acquire(&frame_table_lock);
+    frame->inode = file_get_inode(page->file.file);
+    frame->ofs = page->file.ofs;
+    frame->read_bytes = page->file.read_bytes;
+    if (hash_insert(&frame_cache, &frame->cache_elem) != NULL)
+        frame->inode = NULL;
+    lock_release(&frame_table_lock);
+}
 
-    if (list_empty(&frame_table)) {
-        lock_release(&frame_table_lock);
-        return NULL;
+/* Takes the frames of frame_cache that hold any of the SIZE bytes
+ * of INODE at OFS out of frame_cache, because those bytes were just
+ * written.  Later faults and fault-around then read the file again
+ * instead of sharing stale contents.  Pages that already map one of
+ * the frames keep it.  Cached frames start on page boundaries of
+ * the file, so this looks up each file page the write touched. */
+void vm_invalidate_file_frames(struct inode *inode, off_t ofs, off_t size) {
+    struct frame key = {.inode = inode};
+    struct hash_elem *e;
+
+    if (size <= 0)
+        return;
+    lock_acquire(&frame_table_lock);
+    for (key.ofs = ROUND_DOWN(ofs, PGSIZE); key.ofs < ofs + size; key.ofs += PGSIZE) {
+        e = hash_delete(&frame_cache, &key.cache_elem);
+        if (e != NULL)
+            hash_entry(e, struct frame, cache_elem)->inode = NULL;
     }
+    lock_release(&frame_table_lock);
+}
 
-    if (clock_hand == NULL) {
-        clock_hand = list_begin(&frame_table);
-    }
+/* Unpins FRAME, which holds no page, and returns it to the user
+ * pool. */
+static void frame_free(struct frame *frame) {
+    lock_acquire(&frame_table_lock);
+    frame->pinned = false;
+    cond_broadcast(&frame_unpinned, &frame_table_lock);
+    lock_release(&frame_table_lock);
+    palloc_free_page(frame->kva);
+}
 
-    while (true) {
-        struct frame *f = list_entry(clock_hand, struct frame, elem);
-        void *va = f->page->va;
-        struct thread *t = f->page->owner;
-        uint64_t *pml4 = t->pml4;
+/* Returns true if any page sharing F was accessed since its
+ * accessed bit was last cleared. */
+static bool frame_is_accessed(const struct frame *f) {
+    for (struct page *p = f->page; p != NULL; p = p->next_sharer)
+        if (pml4_is_accessed(p->owner->pml4, p->va))
+            return true;
+    return false;
+}
 
-        if (pml4_is_accessed(pml4, va)) {
-            pml4_set_accessed(pml4, va, false);
-            advance_clock_hand();
-        } else {
-            victim = f;
-            advance_clock_hand();
-            break;
+/* Clears the accessed bit of every page sharing F. */
+static void frame_clear_accessed(struct frame *f) {
+    for (struct page *p = f->page; p != NULL; p = p->next_sharer)
+        pml4_set_accessed(p->owner->pml4, p->va, false);
+}
+
+/* Unpins FRAME and wakes the threads waiting for it. */
+static void frame_unpin(struct frame *frame) {
+    lock_acquire(&frame_table_lock);
+    frame->pinned = false;
+    cond_broadcast(&frame_unpinned, &frame_table_lock);
+    lock_release(&frame_table_lock);
+}
+
+/* Pins PAGE's frame and returns it, blocking while another thread
+ * has it pinned.  Returns NULL if PAGE is not resident, which is
+ * also what a wait for an eviction of PAGE ends with. */
+static struct frame *vm_pin_frame(struct page *page) {
+    struct frame *f;
+
+    lock_acquire(&frame_table_lock);
+    while ((f = page->frame) != NULL && f->pinned)
+        cond_wait(&frame_unpinned, &frame_table_lock);
+    if (f != NULL)
+        f->pinned = true;
+    lock_release(&frame_table_lock);
+    return f;
+}
+
+/* Returns true if F holds a page that may be evicted. */
+static bool frame_evictable(const struct frame *f) {
+    return f->page != NULL && !f->pinned;
+}
+
+/* Takes up to MAX frames to evict into VICTIMS and returns how
+ * many it took.  The first comes from a full turn of the clock; the
+ * rest are frames the clock finds unaccessed within the following
+ * HAND_SPREAD steps.  The frames come back pinned.  Returns 0 if
+ * every frame is pinned or free. */
+static size_t vm_get_victims(struct frame *victims[], size_t max) {
+    size_t cnt = 0, limit = 3 * frame_cnt;
+
+    lock_acquire(&frame_table_lock);
+
+    /* 앞 바늘이 지나간 뒤 다시 접근되지 않은 프레임을 고른다.
+     * 모든 프레임이 계속 접근되면 세 바퀴 뒤에 아무거나 고른다. */
+    for (size_t step = 0; step < limit && cnt < max; step++) {
+        struct frame *front = &frame_table[(clock_hand + hand_spread) % frame_cnt];
+        struct frame *f = &frame_table[clock_hand];
+
+        if (frame_evictable(front))
+            frame_clear_accessed(front);
+        clock_hand = (clock_hand + 1) % frame_cnt;
+
+        if (frame_evictable(f) &&
+            (!frame_is_accessed(f) || (cnt == 0 && step >= 2 * frame_cnt))) {
+            f->pinned = true;
+            victims[cnt++] = f;
+            if (cnt == 1)
+                limit = step + 1 + hand_spread;
         }
     }
 
     lock_release(&frame_table_lock);
 
-    return victim;
+    return cnt;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+/* Writes the CNT anonymous pages in PAGES to swap. */
+static void vm_swap_out_anon(struct page *pages[], size_t cnt) {
+    if (cnt > 0 && !anon_swap_out_cluster(pages, cnt))
+        PANIC("out of swap slots");
+}
 
+/* Evicts a cluster of up to SWAP_CLUSTER frames and returns one of
+ * them, pinned and empty.  The other frames go back to the user
+ * pool, for the faults that follow.  Anonymous victims are written
+ * to swap together, in as few disk commands as possible; a frame
+ * shared copy-on-write is written out once for each page sharing
+ * it.  Return NULL on error.*/
 static struct frame *vm_evict_frame(void) {
-    struct frame *victim = vm_get_victim();
-    if (victim == NULL || victim->page == NULL) {
+    struct frame *victims[SWAP_CLUSTER];
+    struct page *anon[SWAP_CLUSTER];
+    size_t cnt = vm_get_victims(victims, SWAP_CLUSTER), anon_cnt = 0;
+
+    if (cnt == 0) {
         return NULL;
     }
 
-    struct page *p = victim->page;
-    struct thread *t = p->owner;
+    for (size_t i = 0; i < cnt; i++)
+        for (struct page *p = victims[i]->page; p != NULL; p = p->next_sharer) {
+            pml4_clear_page(p->owner->pml4, p->va);
+            if (VM_TYPE(p->operations->type) != VM_ANON) {
+                swap_out(p);
+                continue;
+            }
+            if (anon_cnt == SWAP_CLUSTER) {
+                vm_swap_out_anon(anon, anon_cnt);
+                anon_cnt = 0;
+            }
+            anon[anon_cnt++] = p;
+        }
+    vm_swap_out_anon(anon, anon_cnt);
+
+    for (size_t i = 0; i < cnt; i++) {
+        struct frame *f = victims[i];
+
+        lock_acquire(&frame_table_lock);
+        while (f->page != NULL) frame_unlink(f, f->page);
+        cond_broadcast(&frame_unpinned, &frame_table_lock);
+        lock_release(&frame_table_lock);
+        if (i > 0)
+            frame_free(f);
+    }
+    evict_cnt += cnt;
+    return victims[0];
+}
 
-    swap_out(p);
-    pml4_clear_page(t->pml4, p->va);
-    p->frame = NULL;
-    victim->page = NULL;
-    return victim;
+/* Returns a free frame, pinned, or NULL if the user pool is
+ * exhausted.  Never evicts. */
+struct frame *vm_get_free_frame(void) {
+    void *kva = palloc_get_page(PAL_USER);
+    struct frame *frame;
+
+    if (kva == NULL)
+        return NULL;
+
+    frame = vm_frame_of(kva);
+    ASSERT(frame->page == NULL);
+    lock_acquire(&frame_table_lock);
+    frame->pinned = true;
+    lock_release(&frame_table_lock);
+    return frame;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * space.  The frame comes back pinned; vm_do_claim_page() unpins it once
+ * the page is in. */
 static struct frame *vm_get_frame(void) {
-    struct frame *frame = (struct frame *)malloc(sizeof(struct frame));
+    struct frame *frame = vm_get_free_frame();
 
-    ASSERT(frame != NULL);
-    frame->page = NULL;
-
-    frame->kva = palloc_get_page(PAL_USER);
-    if (frame->kva == NULL) {
+    if (frame == NULL)
         frame = vm_evict_frame();
-        if (frame == NULL)
-            return NULL;
-        frame->page = NULL;
-        return frame;
+    return frame;
+}
+
+/* Unmaps PAGE from its frame, which the caller has pinned, and
+ * unpins the frame.  The frame is freed unless other pages still
+ * share it. */
+static void vm_free_frame(struct page *page) {
+    struct frame *frame = page->frame;
+    bool last;
+
+    ASSERT(frame != NULL && frame->pinned);
+
+    if (page->owner->pml4 != NULL)
+        pml4_clear_page(page->owner->pml4, page->va);
+
+    lock_acquire(&frame_table_lock);
+    frame_unlink(frame, page);
+    last = frame->page == NULL;
+    if (!last) {
+        frame->pinned = false;
+        cond_broadcast(&frame_unpinned, &frame_table_lock);
+    }
+    lock_release(&frame_table_lock);
+
+    if (last)
+        frame_free(frame);
+}
+
+/* Links PAGE with FRAME, which the caller got from
+ * vm_get_free_frame() and filled with PAGE's contents, maps it into
+ * PAGE's owner's address space and unpins FRAME.  On failure, frees
+ * FRAME and returns false. */
+bool vm_map_frame(struct page *page, struct frame *frame) {
+    frame_link(frame, page);
+    if (!pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable)) {
+        vm_free_frame(page);
+        return false;
     }
+    frame_unpin(frame);
+    return true;
+}
+
+/* Prints VM statistics. */
+void vm_print_stats(void) {
+    printf("VM: %lld page faults, %lld evictions, %lld pages shared by fork, "
+           "%lld copied on write\n",
+           fault_cnt, evict_cnt, share_cnt, cow_copy_cnt);
+    printf("VM: %lld file pages mapped around faults, %lld shared from the frame cache\n",
+           around_cnt, cached_cnt);
+    printf("VM: %lld stack pages added, deepest stack %zu kB\n", stack_grow_cnt,
+           stack_deepest / 1024);
+    printf("VM: %lld read faults served by the zero page\n", zero_map_cnt);
+    anon_print_stats();
+    zswap_print_stats();
+    file_print_stats();
+}
+
+/* Testing utility: reads a VM counter via int 0x45.
+ * Input:
+ *   @RAX - 0 for page faults, 1 for evictions, 2 for milliseconds
+ *          since boot, 3 for the running process's stack high-water
+ *          mark in bytes
+ * Output:
+ *   @RAX - The counter's value. */
+static void inspect_vm_stat(struct intr_frame *f) {
+    switch (f->R.rax) {
+        case 0:
+            f->R.rax = fault_cnt;
+            break;
+        case 1:
+            f->R.rax = evict_cnt;
+            break;
+        case 2:
+            f->R.rax = timer_ticks() * 1000 / TIMER_FREQ;
+            break;
+        case 3:
+            f->R.rax = USER_STACK - (uint64_t)thread_current()->stack_bottom;
+            break;
+        default:
+            f->R.rax = -1;
+            break;
+    }
+}
+
+/* Returns true if a fault at ADDR, with the user stack pointer at
+ * RSP, is a stack access: within vm_stack_max of USER_STACK and no
+ * more than 8 bytes below RSP, since PUSH faults before it moves
+ * RSP. */
+static bool vm_is_stack_access(void *addr, uintptr_t rsp) {
+    uintptr_t a = (uintptr_t)addr;
+
+    return a < USER_STACK && a >= USER_STACK - vm_stack_max && a + 8 >= rsp;
+}
+
+/* Growing the stack.  Adds every page from ADDR's up to the stack
+ * bottom at once, so that a fault far below the stack does not turn
+ * into a fault per page.  Claims ADDR's page, and up to
+ * STACK_PREFAULT pages above it while free frames last; the rest
+ * fault in as they are touched.  The stack bottom never rises, so
+ * it doubles as the process's stack high-water mark. */
+static bool vm_stack_growth(void *addr) {
+    struct thread *t = thread_current();
+    uint8_t *va = pg_round_down(addr);
+    uint8_t *p;
+    size_t n;
+
+    for (p = (uint8_t *)t->stack_bottom - PGSIZE; p >= va; p -= PGSIZE) {
+        if (!vm_alloc_page(VM_ANON | VM_MARKER_0, p, true)) {
+            return false;
+        }
+        t->stack_bottom = p;
+        stack_grow_cnt++;
+    }
+    if (USER_STACK - (uintptr_t)va > stack_deepest)
+        stack_deepest = USER_STACK - (uintptr_t)va;
+
+    if (!vm_do_claim_page(spt_lookup_page(&t->spt, va))) {
+        return false;
+    }
+    for (p = va + PGSIZE, n = 0; n < STACK_PREFAULT; p += PGSIZE, n++) {
+        struct page *page = spt_lookup_page(&t->spt, p);
+
+        if (page == NULL || page->frame != NULL || !vm_claim_frame(page, false))
+            break;
+    }
+    return true;
+}
+
+/* Handle the fault on write_protected page.  PAGE is writable but
+ * mapped read-only because fork() left its frame shared.  The last
+ * page left on the frame just gets write access back; any other
+ * gets a private copy. */
+static bool vm_handle_wp(struct page *page) {
+    struct frame *old = vm_pin_frame(page), *new;
+
+    /* 그 사이 내보내졌으면 다시 fault가 나면서 읽어 들인다. */
+    if (old == NULL)
+        return true;
+
+    if (old->page == page && page->next_sharer == NULL) {
+        pml4_set_writable(page->owner->pml4, page->va, true);
+        frame_unpin(old);
+        return true;
+    }
+
+    new = vm_get_frame();
+    if (new == NULL) {
+        frame_unpin(old);
+        return false;
+    }
+    memcpy(new->kva, old->kva, PGSIZE);
 
     lock_acquire(&frame_table_lock);
-    list_push_back(&frame_table, &frame->elem);
+    frame_unlink(old, page);
+    old->pinned = false;
+    cond_broadcast(&frame_unpinned, &frame_table_lock);
     lock_release(&frame_table_lock);
 
-    return frame;
+    /* fault가 TLB의 읽기 전용 항목을 이미 무효화했으므로 PTE만 바꾸면 된다. */
+    cow_copy_cnt++;
+    return vm_map_frame(page, new);
+}
+
+/* Returns true if PAGE holds nothing but zeros and has no frame:
+ * an anonymous page never written, or never filled with anything
+ * but zeros, that is not in swap. */
+static bool page_is_zero_fill(struct page *page) {
+    if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+        struct lazy_segment_arg *aux = page->uninit.aux;
+
+        return VM_TYPE(page->uninit.type) == VM_ANON &&
+               (page->uninit.init == NULL || (aux != NULL && aux->page_read_bytes == 0));
+    }
+    return VM_TYPE(page->operations->type) == VM_ANON && page->frame == NULL &&
+           page->anon.swap_slot == SIZE_MAX && page->anon.zentry == NULL;
 }
 
-/* Growing the stack. */
-static void vm_stack_growth(void *addr UNUSED) {}
+/* Maps PAGE, a zero-fill page that faulted on a read, to the zero
+ * page read-only.  It takes no frame until it is first written, and
+ * eviction never sees it.  Returns false if PAGE is not zero-fill. */
+static bool vm_map_zero_page(struct page *page) {
+    if (!page_is_zero_fill(page))
+        return false;
+
+    if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+        /* lazy_load_segment이 채울 내용이 없으니 aux는 여기서 놓는다. */
+        void *aux = page->uninit.aux;
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) {}
+        page->uninit.init = NULL;
+        if (!swap_in(page, NULL))
+            return false;
+        free(aux);
+    }
+    if (!pml4_set_page(page->owner->pml4, page->va, zero_kva, false))
+        return false;
+    zero_map_cnt++;
+    return true;
+}
 
 /* Return true on success */
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write,
@@ -251,6 +703,8 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
     void *va = pg_round_down(addr);
     struct supplemental_page_table *spt = &thread_current()->spt;
     struct page *page = spt_find_page(spt, va);
+
+    fault_cnt++;
     if (user && is_kernel_vaddr(addr)) {
         return false;
     }
@@ -259,25 +713,68 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
     }
 
     if (page == NULL) {
-        // TODO: stack_growth 용
-        return false;
+        /* 시스템 콜 안에서 난 fault면 진입할 때 저장해 둔 사용자 rsp를 쓴다. */
+        uintptr_t rsp = user ? f->rsp : (uintptr_t)thread_current()->rsp_stack;
+
+        return vm_is_stack_access(addr, rsp) && vm_stack_growth(addr);
     }
     if (write && !page->writable) {
         return false;
     }
 
     if (!not_present) {
-        // TODO:cow 용
+        /* 쓰기 가능한 페이지의 보호 fault는 0 페이지나 fork()가 공유한 프레임에 쓴 것이다. */
+        if (page->frame == NULL) {
+            pml4_clear_page(thread_current()->pml4, page->va);
+            return write && vm_do_claim_page(page);
+        }
+        return write && vm_handle_wp(page);
+    }
+    if (!write && vm_map_zero_page(page)) {
+        return true;
+    }
+    if (!vm_do_claim_page(page)) {
         return false;
     }
-    return vm_do_claim_page(page);
+    if (VM_TYPE(page->operations->type) == VM_FILE) {
+        vm_fault_around(page);
+    }
+    return true;
+}
+
+/* Releases PAGE's frame before PAGE is destroyed, waiting first
+ * if another thread is evicting it.  A dirty file page is written
+ * back while it still has the frame.  A page with no frame may
+ * still be mapped to the zero page. */
+static void vm_release_frame(struct page *page) {
+    if (vm_pin_frame(page) != NULL) {
+        if (VM_TYPE(page->operations->type) == VM_FILE && page->owner->pml4 != NULL)
+            swap_out(page);
+        vm_free_frame(page);
+    } else if (page->owner->pml4 != NULL)
+        pml4_clear_page(page->owner->pml4, page->va);
+}
+
+/* Returns true if the running process may access ADDR, writing to
+ * it if WRITE is true, without the fault handler failing: ADDR is in
+ * a page of the SPT or of a VMA, or in reach of stack growth. */
+bool vm_check_access(void *addr, bool write) {
+    struct thread *t = thread_current();
+    struct page *page;
+
+    if (!is_user_vaddr(addr) || (uintptr_t)addr < 0x400000)
+        return false;
+    page = spt_find_page(&t->spt, addr);
+    if (page == NULL)
+        return vm_is_stack_access(addr, (uintptr_t)t->rsp_stack);
+    return !write || page->writable;
 }
 
 /* Free the page.
  * DO NOT MODIFY THIS FUNCTION. */
 void vm_dealloc_page(struct page *page) {
     destroy(page);
-    free(page);
+    kmem_cache_free(page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -293,25 +790,189 @@ bool vm_claim_page(void *va UNUSED) {
     return false;
 }
 
-/* Claim the PAGE and set up the mmu. */
-static bool vm_do_claim_page(struct page *page) {
-    struct frame *frame = vm_get_frame();
+/* Maps PAGE, a file page, to a frame of frame_cache that already
+ * holds it.  Returns false if there is none.  While the file is
+ * being run, and so denied writes, a frame is shared only if no
+ * mapping of it, PAGE included, is writable: otherwise a write
+ * through an mmap would change the code of the running program. */
+static bool vm_share_cached_frame(struct page *page) {
+    struct frame key = {.inode = file_get_inode(page->file.file),
+                        .ofs = page->file.ofs,
+                        .read_bytes = page->file.read_bytes};
+    bool running = inode_is_write_denied(key.inode);
+    struct frame *f = NULL;
+    struct hash_elem *e;
+
+    if (running && page->writable)
+        return false;
+    lock_acquire(&frame_table_lock);
+    e = hash_find(&frame_cache, &key.cache_elem);
+    /* 실행 파일의 세그먼트 끝 페이지는 같은 오프셋이라도 0으로 채운 꼬리가 다르다. */
+    if (e != NULL && !(f = hash_entry(e, struct frame, cache_elem))->pinned &&
+        f->read_bytes == key.read_bytes && !(running && frame_has_writer(f)))
+        f->pinned = true;
+    else
+        f = NULL;
+    lock_release(&frame_table_lock);
 
+    if (f == NULL)
+        return false;
+    frame_link(f, page);
+    if (!pml4_set_page(page->owner->pml4, page->va, f->kva, page->writable)) {
+        vm_free_frame(page);
+        return false;
+    }
+    frame_unpin(f);
+    cached_cnt++;
+    return true;
+}
+
+/* Claims a frame for PAGE, evicting one if EVICT is true, fills it
+ * and maps it.  A file page shares the frame of another mapping of
+ * the same file page if there is one.  If another thread
+ * is evicting PAGE, waits for the eviction to finish first, so that
+ * PAGE is read back from where the eviction wrote it. */
+static bool vm_claim_frame(struct page *page, bool evict) {
+    struct frame *frame = vm_pin_frame(page);
+
+    if (frame != NULL) {
+        /* 내보내지지 않고 남았으면 다시 매핑만 한다.  익명 페이지는 공유 중이면
+         * copy-on-write라서 읽기 전용이고, 파일 페이지는 함께 쓴다. */
+        bool writable = page->writable && (VM_TYPE(page->operations->type) == VM_FILE ||
+                                           (frame->page == page && page->next_sharer == NULL));
+        bool success = pml4_set_page(page->owner->pml4, page->va, frame->kva, writable);
+
+        frame_unpin(frame);
+        return success;
+    }
+
+    if (page_get_type(page) == VM_FILE) {
+        if (VM_TYPE(page->operations->type) == VM_UNINIT && !swap_in(page, NULL))
+            return false;
+        if (vm_share_cached_frame(page))
+            return true;
+    }
+
+    frame = evict ? vm_get_frame() : vm_get_free_frame();
     // 페이지 할당 실패.....
     if (frame == NULL) {
         return false;
     }
 
     /* Set links */
-    frame->page = page;
-    page->frame = frame;
+    frame_link(frame, page);
 
     /* 사용자 가상 주소를 커널 주소 맵핑 */
     if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable)) {
+        vm_free_frame(page);
         return false;
     }
 
-    return swap_in(page, frame->kva);
+    bool success = swap_in(page, frame->kva);
+    if (success && VM_TYPE(page->operations->type) == VM_FILE)
+        frame_cache_insert(frame, page);
+    frame_unpin(frame);
+    return success;
+}
+
+/* Claim the PAGE and set up the mmu. */
+static bool vm_do_claim_page(struct page *page) {
+    return vm_claim_frame(page, true);
+}
+
+/* Maps the pages of the FAULT_AROUND-page window around PAGE, a
+ * file page that just faulted in, that are not resident yet.  Pages
+ * other mappings have in frame_cache are shared; the rest are read
+ * from the file into free frames.  Never evicts: stops once the
+ * user pool runs dry. */
+static void vm_fault_around(struct page *page) {
+    struct supplemental_page_table *spt = &page->owner->spt;
+    struct vma *vma = vma_find(spt, page->va);
+    uint8_t *start, *end;
+
+    if (vma == NULL)
+        return;
+    start = (uint8_t *)ROUND_DOWN((uintptr_t)page->va, FAULT_AROUND * PGSIZE);
+    end = start + FAULT_AROUND * PGSIZE;
+    if (start < (uint8_t *)vma->start)
+        start = vma->start;
+    if (end > (uint8_t *)vma->end)
+        end = vma->end;
+
+    for (uint8_t *va = start; va < end; va += PGSIZE) {
+        struct page *p = spt_lookup_page(spt, va);
+
+        if (p == page || (p != NULL && (p->frame != NULL || page_get_type(p) != VM_FILE)))
+            continue;
+        if (p == NULL && (p = vma_create_page(vma, va)) == NULL)
+            break;
+        if (!vm_claim_frame(p, false))
+            break;
+        around_cnt++;
+    }
+}
+
+/* Gives CHILD, a new page of the running process, the contents of
+ * PARENT.  A resident anonymous PARENT shares its frame with CHILD
+ * copy-on-write: both are mapped read-only until vm_handle_wp()
+ * separates them.  A resident file page is shared for good, writable
+ * if the mapping is.  Otherwise CHILD gets a frame of its own, filled
+ * from PARENT's frame or from swap; a file page that is not resident
+ * is left for CHILD to read from the file when it faults. */
+static bool vm_copy_page(struct page *child, struct page *parent) {
+    /* 부모 프레임이 내보내지는 중이면 끝날 때까지 기다렸다가, 복사하는 동안 고정한다. */
+    struct frame *pf = vm_pin_frame(parent);
+    struct frame *frame;
+
+    if (pf == NULL && VM_TYPE(parent->operations->type) == VM_FILE) {
+        return true;
+    }
+
+    if (pf != NULL) {
+        bool file = VM_TYPE(parent->operations->type) == VM_FILE;
+
+        if (!swap_in(child, NULL)) {
+            frame_unpin(pf);
+            return false;
+        }
+        frame_link(pf, child);
+        if (!pml4_set_page(child->owner->pml4, child->va, pf->kva, file && child->writable)) {
+            vm_free_frame(child);
+            return false;
+        }
+        /* 부모는 fork() 안에서 기다리는 중이라, 다시 돌 때 부모의 PCID가 비워진다. */
+        if (!file)
+            pml4_set_writable(parent->owner->pml4, parent->va, false);
+        frame_unpin(pf);
+        share_cnt++;
+        return true;
+    }
+
+    /* 아직 0인 페이지는 자식도 처음 읽을 때 0 페이지에 매핑된다. */
+    if (pf == NULL && page_is_zero_fill(parent)) {
+        return swap_in(child, NULL);
+    }
+
+    frame = vm_get_frame();
+    if (frame == NULL || !swap_in(child, NULL)) {
+        if (frame != NULL)
+            frame_free(frame);
+        if (pf != NULL)
+            frame_unpin(pf);
+        return false;
+    }
+
+    if (pf != NULL) {
+        memcpy(frame->kva, pf->kva, PGSIZE);
+        frame_unpin(pf);
+    } else if (VM_TYPE(parent->operations->type) == VM_ANON) {
+        anon_read_swap(parent, frame->kva);
+    } else {
+        frame_free(frame);
+        return false;
+    }
+
+    return vm_map_frame(child, frame);
 }
 
 uint64_t hash_page_func(const struct hash_elem *e, void *aux UNUSED) {
@@ -331,6 +992,8 @@ bool page_less_func(const struct hash_elem *a, const struct hash_elem *b, void *
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
     hash_init(&spt->spt_hash, hash_page_func, page_less_func, NULL);
+    list_init(&spt->vmas);
+    spt->vma_cache = NULL;
 }
 
 /* Copy supplemental page table from src to dst */
@@ -342,6 +1005,11 @@ void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
  */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
                                   struct supplemental_page_table *src UNUSED) {
+    // 영역은 통째로 복사하고, 아직 손대지 않은 영역 페이지는 자식이 fault 때 새로 만든다
+    if (!vma_copy(dst, src)) {
+        return false;
+    }
+
     // hash_first/hash_next로 src->spt_hash의 모든 페이지 엔트리를 순회함
     struct hash_iterator i;
     hash_first(&i, &src->spt_hash);
@@ -354,9 +1022,26 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 
         // uninit.type 안에 특수 마커 플래그 VM_MARKER_0이 켜져 있느냐를 확인하는 거임
         if (type == VM_UNINIT) {
+            if (vma_find(src, upage) != NULL) {
+                continue;
+            }
+
             vm_initializer *init = parent_page->uninit.init;  // UNINIT일 때 초기화 함수
             void *aux = parent_page->uninit.aux;  // UNINIT일 때 보조 데이터 (레이지 세그먼트 용)
-            vm_alloc_page_with_initializer(type, upage, writable, init, aux);
+
+            // lazy_load_segment()가 aux를 free하므로 자식은 자기 사본을 가져야 함
+            if (aux != NULL) {
+                void *copy = malloc(sizeof(struct lazy_segment_arg));
+                if (copy == NULL)
+                    return false;
+                memcpy(copy, aux, sizeof(struct lazy_segment_arg));
+                aux = copy;
+            }
+            if (!vm_alloc_page_with_initializer(parent_page->uninit.type, upage, writable, init,
+                                                aux)) {
+                free(aux);
+                return false;
+            }
             continue;
         }
 
@@ -365,13 +1050,10 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
             return false;
         }
 
-        // 자식 쪽에서 프레임을 즉시 할당하고 매핑함
-        if (!vm_claim_page(upage)) {
+        // 자식 쪽에서 프레임을 즉시 할당하고 부모 내용을 복사함 (부모 페이지가 swap에 있어도 됨)
+        if (!vm_copy_page(spt_find_page(dst, upage), parent_page)) {
             return false;
         }
-
-        struct page *child_page = spt_find_page(dst, upage);
-        memcpy(child_page->frame->kva, parent_page->frame->kva, PGSIZE);
     }
 
     return true;
@@ -386,7 +1068,8 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 
 static void page_destroy_all(struct hash_elem *e, void *aux UNUSED) {
     struct page *page = hash_entry(e, struct page, hash_elem);
-    /* dealloc을 해줌*/
+    /* 프레임을 놓고 dealloc을 해줌*/
+    vm_release_frame(page);
     vm_dealloc_page(page);
 }
 
@@ -395,4 +1078,5 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
     /* TODO: Destroy all the supplemental_page_table hold by thread and
      * TODO: writeback all the modified contents to the storage. */
     hash_destroy(&spt->spt_hash, page_destroy_all);
+    vma_destroy_all(spt);
 }
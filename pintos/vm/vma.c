@@ -0,0 +1,195 @@
+/* vma.c: Virtual memory areas.
+ *
+ * Mapping an ELF segment used to create a `struct page' and a
+ * `struct lazy_segment_arg' for each of its pages up front, so
+ * that exec() cost time and kernel memory in proportion to the
+ * size of the program, touched or not.  A VMA describes the whole
+ * range instead, and spt_find_page() creates a page from it the
+ * first time the page is looked up, normally from the page
+ * fault. */
+
+#include "vm/vma.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* Returns true if [START, END) overlaps a VMA or a page of SPT. */
+static bool vma_range_used(struct supplemental_page_table *spt, uint8_t *start, uint8_t *end) {
+    struct list_elem *e;
+    struct hash_iterator i;
+
+    for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e)) {
+        struct vma *vma = list_entry(e, struct vma, elem);
+
+        if ((uint8_t *)vma->start < end && start < (uint8_t *)vma->end)
+            return true;
+    }
+
+    /* 범위와 테이블 중 작은 쪽을 훑는다. */
+    if ((size_t)(end - start) / PGSIZE <= hash_size(&spt->spt_hash)) {
+        for (uint8_t *va = start; va < end; va += PGSIZE)
+            if (spt_lookup_page(spt, va) != NULL)
+                return true;
+        return false;
+    }
+    hash_first(&i, &spt->spt_hash);
+    while (hash_next(&i)) {
+        struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+
+        if ((uint8_t *)page->va >= start && (uint8_t *)page->va < end)
+            return true;
+    }
+    return false;
+}
+
+/* Adds to SPT an area of LENGTH bytes at START, a page boundary,
+ * whose pages are of type TYPE, are filled by INIT with the first
+ * READ_BYTES bytes of FILE from OFS and zeros after, and are
+ * writable if WRITABLE.  The area keeps its own handle on FILE.
+ * Returns false if the area overlaps another or memory runs out. */
+bool vma_map(struct supplemental_page_table *spt, void *start, size_t length, bool writable,
+             enum vm_type type, struct file *file, off_t ofs, size_t read_bytes,
+             vm_initializer *init) {
+    uint8_t *end = (uint8_t *)start + ROUND_UP(length, PGSIZE);
+    struct vma *vma;
+    struct list_elem *e;
+
+    ASSERT(pg_ofs(start) == 0);
+    ASSERT(read_bytes <= length);
+
+    if (length == 0 || end <= (uint8_t *)start || vma_range_used(spt, start, end))
+        return false;
+
+    vma = malloc(sizeof *vma);
+    if (vma == NULL)
+        return false;
+    *vma = (struct vma){.start = start,
+                        .end = end,
+                        .file = file != NULL ? file_reopen(file) : NULL,
+                        .ofs = ofs,
+                        .read_bytes = read_bytes,
+                        .writable = writable,
+                        .type = type,
+                        .init = init};
+    if (file != NULL && vma->file == NULL) {
+        free(vma);
+        return false;
+    }
+
+    for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+        if (list_entry(e, struct vma, elem)->start > start)
+            break;
+    list_insert(e, &vma->elem);
+    return true;
+}
+
+/* Returns the VMA of SPT that contains VA, or NULL. */
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va) {
+    struct list_elem *e;
+
+    /* 연속된 fault는 대개 같은 영역에서 난다. */
+    if (spt->vma_cache != NULL && va >= spt->vma_cache->start && va < spt->vma_cache->end)
+        return spt->vma_cache;
+
+    for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e)) {
+        struct vma *vma = list_entry(e, struct vma, elem);
+
+        if (va < vma->start)
+            break;
+        if (va < vma->end)
+            return spt->vma_cache = vma;
+    }
+    return NULL;
+}
+
+/* Returns how many bytes of the page at VA, a page boundary within
+ * VMA, come from its file. */
+size_t vma_read_bytes(const struct vma *vma, const void *va) {
+    size_t ofs = (const uint8_t *)va - (const uint8_t *)vma->start;
+
+    if (ofs >= vma->read_bytes)
+        return 0;
+    return vma->read_bytes - ofs < PGSIZE ? vma->read_bytes - ofs : PGSIZE;
+}
+
+/* Creates the page at VA, a page boundary within VMA, in the
+ * running process's supplemental page table and returns it, or
+ * returns NULL if memory runs out.  Pages of an area with an INIT
+ * get a `struct lazy_segment_arg'; file-backed pages find their
+ * place in the file from the VMA themselves. */
+struct page *vma_create_page(struct vma *vma, void *va) {
+    struct lazy_segment_arg *aux = NULL;
+
+    ASSERT(pg_ofs(va) == 0);
+
+    if (vma->init != NULL) {
+        aux = malloc(sizeof *aux);
+        if (aux == NULL)
+            return NULL;
+        aux->file = vma->file;
+        aux->ofs = vma->ofs + ((uint8_t *)va - (uint8_t *)vma->start);
+        aux->page_read_bytes = vma_read_bytes(vma, va);
+        aux->page_zero_bytes = PGSIZE - aux->page_read_bytes;
+    }
+    if (!vm_alloc_page_with_initializer(vma->type, va, vma->writable, vma->init, aux)) {
+        free(aux);
+        return NULL;
+    }
+    return spt_lookup_page(&thread_current()->spt, va);
+}
+
+/* Copies the VMAs of SRC into DST, which has none.  Each copy gets
+ * its own handle on the file. */
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src) {
+    struct list_elem *e;
+
+    for (e = list_begin(&src->vmas); e != list_end(&src->vmas); e = list_next(e)) {
+        struct vma *vma = list_entry(e, struct vma, elem);
+        struct vma *copy = malloc(sizeof *copy);
+
+        if (copy == NULL)
+            return false;
+        *copy = *vma;
+        if (vma->file != NULL && (copy->file = file_reopen(vma->file)) == NULL) {
+            free(copy);
+            return false;
+        }
+        list_push_back(&dst->vmas, &copy->elem);
+    }
+    return true;
+}
+
+/* Removes VMA from SPT, with the pages created from it, and frees
+ * it. */
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma) {
+    for (uint8_t *va = vma->start; va < (uint8_t *)vma->end; va += PGSIZE) {
+        struct page *page = spt_lookup_page(spt, va);
+
+        if (page != NULL)
+            spt_remove_page(spt, page);
+    }
+
+    list_remove(&vma->elem);
+    if (spt->vma_cache == vma)
+        spt->vma_cache = NULL;
+    file_close(vma->file);
+    free(vma);
+}
+
+/* Frees every VMA of SPT. */
+void vma_destroy_all(struct supplemental_page_table *spt) {
+    while (!list_empty(&spt->vmas)) {
+        struct vma *vma = list_entry(list_pop_front(&spt->vmas), struct vma, elem);
+
+        file_close(vma->file);
+        free(vma);
+    }
+    spt->vma_cache = NULL;
+}
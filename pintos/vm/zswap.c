@@ -0,0 +1,382 @@
+/* zswap.c: Compressed in-memory cache in front of the swap disk.
+ *
+ * Evicted anonymous pages are compressed and kept in malloc()'d
+ * blocks from the kernel pool, instead of being written to the
+ * swap disk, which takes 8 PIO sector transfers per page.  Only
+ * once the store holds more than zswap_max_pages pages of memory
+ * are its least recently stored pages written back to the swap
+ * disk, in clusters.  Pages that do not compress to 3/4 of a page
+ * or less go to the swap disk right away.
+ *
+ * Write-back runs without zswap_lock held, so that stores, loads
+ * and drops do not wait behind the disk.  An entry being written
+ * back is off lru_list but still serves loads and copies; a page
+ * loaded or dropped meanwhile is only detached from the entry, and
+ * the swap slot written for it is given back afterward.
+ *
+ * Pages are compressed with a small LZ77 coder in the style of
+ * LZ4: a 4-byte hash table finds earlier occurrences of the next
+ * 4 bytes, and the output is a series of sequences, each a token
+ * byte holding the literal run length and the match length, the
+ * literals, and a 2-byte match offset. */
+
+#include "vm/zswap.h"
+
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* A compressed page. */
+struct zswap_entry {
+    struct list_elem elem; /* Element in lru_list, unless WRITING. */
+    struct page *page;     /* Page whose contents these are, or NULL
+                              if it left the store while WRITING. */
+    bool writing;          /* Being written back to the swap disk. */
+    size_t size;           /* Bytes in DATA. */
+    uint8_t data[];        /* Compressed contents. */
+};
+
+/* Largest compressed page worth keeping. */
+#define ZSWAP_SIZE_MAX (PGSIZE / 4 * 3)
+
+size_t zswap_max_pages = SIZE_MAX;
+
+/* Compressed pages, least recently stored first.  The lock also
+ * guards the compressor's scratch space and the statistics. */
+static struct list lru_list;
+static struct lock zswap_lock;
+static size_t stored_bytes; /* Bytes of memory held by entries. */
+static size_t entry_cnt;    /* Number of entries. */
+
+/* Pages being written back go through here.  Only one thread
+ * writes back at a time. */
+static uint8_t *bounce;
+static bool shrinking;
+
+/* Statistics. */
+static long long store_cnt;     /* Pages stored. */
+static long long reject_cnt;    /* Pages that did not compress well. */
+static long long writeback_cnt; /* Pages written back to disk. */
+static long long hit_cnt;       /* Swap-ins served from the store. */
+static long long miss_cnt;      /* Swap-ins that read the disk. */
+static long long raw_bytes;     /* Bytes of pages stored. */
+static long long packed_bytes;  /* Bytes they compressed to. */
+
+static size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+static void lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+/* Sets up the store. */
+void zswap_init(void) {
+    void *base;
+    size_t user_pages;
+
+    list_init(&lru_list);
+    lock_init_named(&zswap_lock, "zswap");
+    if (zswap_max_pages == SIZE_MAX) {
+        palloc_pool_range(PAL_USER, &base, &user_pages);
+        zswap_max_pages = user_pages / 4;
+    }
+    bounce = palloc_get_multiple(PAL_ASSERT, SWAP_CLUSTER);
+}
+
+/* Returns the kernel memory that an entry of SIZE bytes takes. */
+static size_t entry_bytes(size_t size) {
+    return sizeof(struct zswap_entry) + size;
+}
+
+/* Compresses resident anonymous PAGE into the store.  Returns
+ * false, storing nothing, if the page does not compress well or
+ * the store is disabled or out of memory. */
+bool zswap_store(struct page *page) {
+    static uint8_t scratch[ZSWAP_SIZE_MAX];
+    struct zswap_entry *e;
+    size_t size;
+
+    if (zswap_max_pages == 0)
+        return false;
+
+    lock_acquire(&zswap_lock);
+    size = lz_compress(page->frame->kva, PGSIZE, scratch, sizeof scratch);
+    e = size > 0 ? malloc(entry_bytes(size)) : NULL;
+    if (e == NULL) {
+        reject_cnt++;
+        lock_release(&zswap_lock);
+        return false;
+    }
+
+    e->page = page;
+    e->writing = false;
+    e->size = size;
+    memcpy(e->data, scratch, size);
+    list_push_back(&lru_list, &e->elem);
+    page->anon.zentry = e;
+    stored_bytes += entry_bytes(size);
+    entry_cnt++;
+    store_cnt++;
+    raw_bytes += PGSIZE;
+    packed_bytes += size;
+    lock_release(&zswap_lock);
+    return true;
+}
+
+/* Frees entry E, which is off lru_list.  zswap_lock must be
+ * held. */
+static void free_entry(struct zswap_entry *e) {
+    stored_bytes -= entry_bytes(e->size);
+    entry_cnt--;
+    free(e);
+}
+
+/* Removes entry E from the store and frees it.  An entry being
+ * written back is only detached from its page; zswap_shrink()
+ * frees it when the write is done.  zswap_lock must be held. */
+static void remove_entry(struct zswap_entry *e) {
+    e->page->anon.zentry = NULL;
+    if (e->writing) {
+        e->page = NULL;
+        return;
+    }
+    list_remove(&e->elem);
+    free_entry(e);
+}
+
+/* If anonymous PAGE is in the store, decompresses it into KVA,
+ * removes it from the store and returns true.  Otherwise returns
+ * false, and the caller reads the page from the swap disk. */
+bool zswap_load(struct page *page, void *kva) {
+    struct zswap_entry *e;
+
+    lock_acquire(&zswap_lock);
+    e = page->anon.zentry;
+    if (e != NULL) {
+        lz_decompress(e->data, e->size, kva, PGSIZE);
+        remove_entry(e);
+        hit_cnt++;
+    } else if (page->anon.swap_slot != SIZE_MAX)
+        miss_cnt++;
+    lock_release(&zswap_lock);
+    return e != NULL;
+}
+
+/* If anonymous PAGE is in the store, decompresses it into KVA,
+ * leaving it in the store, and returns true.  Otherwise returns
+ * false. */
+bool zswap_copy(struct page *page, void *kva) {
+    struct zswap_entry *e;
+
+    lock_acquire(&zswap_lock);
+    e = page->anon.zentry;
+    if (e != NULL)
+        lz_decompress(e->data, e->size, kva, PGSIZE);
+    lock_release(&zswap_lock);
+    return e != NULL;
+}
+
+/* Removes anonymous PAGE from the store, if it is there. */
+void zswap_drop(struct page *page) {
+    lock_acquire(&zswap_lock);
+    if (page->anon.zentry != NULL)
+        remove_entry(page->anon.zentry);
+    lock_release(&zswap_lock);
+}
+
+/* Writes the least recently stored pages back to the swap disk,
+ * SWAP_CLUSTER at a time, until the store is within its budget.
+ * Returns at once if another thread is already at it. */
+void zswap_shrink(void) {
+    lock_acquire(&zswap_lock);
+    if (shrinking) {
+        lock_release(&zswap_lock);
+        return;
+    }
+    shrinking = true;
+    while (stored_bytes > zswap_max_pages * PGSIZE && !list_empty(&lru_list)) {
+        struct zswap_entry *batch[SWAP_CLUSTER];
+        void *kvas[SWAP_CLUSTER];
+        size_t slots[SWAP_CLUSTER];
+        size_t cnt = 0;
+
+        while (cnt < SWAP_CLUSTER && !list_empty(&lru_list)) {
+            struct zswap_entry *e = list_entry(list_pop_front(&lru_list), struct zswap_entry, elem);
+
+            e->writing = true;
+            kvas[cnt] = bounce + cnt * PGSIZE;
+            lz_decompress(e->data, e->size, kvas[cnt], PGSIZE);
+            batch[cnt++] = e;
+        }
+
+        /* 디스크에 쓰는 동안은 lock을 놓는다.  그 사이의 load와 copy는 남아 있는
+         * 압축본을 쓰고, load나 drop된 페이지는 항목에서 떨어져 나간다. */
+        lock_release(&zswap_lock);
+        if (!anon_write_swap(kvas, cnt, slots))
+            PANIC("out of swap slots");
+        lock_acquire(&zswap_lock);
+
+        for (size_t i = 0; i < cnt; i++) {
+            struct zswap_entry *e = batch[i];
+
+            if (e->page != NULL) {
+                e->page->anon.swap_slot = slots[i];
+                e->page->anon.zentry = NULL;
+            } else
+                anon_free_slot(slots[i]);
+            free_entry(e);
+        }
+        writeback_cnt += cnt;
+    }
+    shrinking = false;
+    lock_release(&zswap_lock);
+}
+
+/* Prints statistics. */
+void zswap_print_stats(void) {
+    long long ratio = packed_bytes > 0 ? raw_bytes * 100 / packed_bytes : 0;
+    long long loads = hit_cnt + miss_cnt;
+
+    printf("zswap: %lld stored, %lld rejected, %lld written back, %zu held in %zu bytes\n",
+           store_cnt, reject_cnt, writeback_cnt, entry_cnt, stored_bytes);
+    printf("zswap: compression ratio %lld.%02lld, %lld hits of %lld loads (%lld%%)\n",
+           ratio / 100, ratio % 100, hit_cnt, loads, loads > 0 ? hit_cnt * 100 / loads : 0);
+}
+
+/* LZ compressor. */
+
+#define MIN_MATCH 4
+#define HASH_BITS 12
+#define NO_POS 0xffff
+
+static uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static size_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/* Appends LEN, less the 15 that fit in a token nibble, to DST at
+ * *OP as a run of 255s and a final byte.  Returns false if that
+ * would go past CAP. */
+static bool put_length(uint8_t *dst, size_t *op, size_t cap, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (*op >= cap)
+            return false;
+        dst[(*op)++] = 255;
+    }
+    if (*op >= cap)
+        return false;
+    dst[(*op)++] = len;
+    return true;
+}
+
+/* Appends a sequence of the LIT_LEN literals at LIT, followed, if
+ * MATCH_LEN is nonzero, by a match of MATCH_LEN bytes at OFFSET
+ * bytes back, to DST at *OP.  Returns false if that would go past
+ * CAP. */
+static bool put_sequence(uint8_t *dst, size_t *op, size_t cap, const uint8_t *lit, size_t lit_len,
+                         size_t offset, size_t match_len) {
+    size_t m = match_len > 0 ? match_len - MIN_MATCH : 0;
+    uint8_t token = (lit_len < 15 ? lit_len : 15) << 4 | (m < 15 ? m : 15);
+
+    if (*op >= cap)
+        return false;
+    dst[(*op)++] = token;
+    if (lit_len >= 15 && !put_length(dst, op, cap, lit_len - 15))
+        return false;
+    if (*op + lit_len > cap)
+        return false;
+    memcpy(dst + *op, lit, lit_len);
+    *op += lit_len;
+    if (match_len == 0)
+        return true;
+
+    if (*op + 2 > cap)
+        return false;
+    dst[(*op)++] = offset;
+    dst[(*op)++] = offset >> 8;
+    return m < 15 || put_length(dst, op, cap, m - 15);
+}
+
+/* Compresses the LEN bytes at SRC into DST.  Returns the
+ * compressed size, or 0 if it would be more than CAP bytes.  LEN
+ * must be less than 64 kB.  The caller serializes calls, because
+ * the hash table is shared. */
+static size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    static uint16_t table[1 << HASH_BITS];
+    size_t ip = 0, anchor = 0, op = 0;
+
+    ASSERT(len < NO_POS);
+    memset(table, 0xff, sizeof table);
+    while (ip + MIN_MATCH <= len) {
+        size_t h = hash32(read32(src + ip));
+        size_t ref = table[h];
+
+        table[h] = ip;
+        if (ref != NO_POS && read32(src + ref) == read32(src + ip)) {
+            size_t match_len = MIN_MATCH;
+
+            while (ip + match_len < len && src[ref + match_len] == src[ip + match_len])
+                match_len++;
+            if (!put_sequence(dst, &op, cap, src + anchor, ip - anchor, ip - ref, match_len))
+                return 0;
+            ip += match_len;
+            anchor = ip;
+        } else
+            ip++;
+    }
+    if (!put_sequence(dst, &op, cap, src + anchor, len - anchor, 0, 0))
+        return 0;
+    return op;
+}
+
+/* Reads a length continued past a token nibble from SRC at *IP. */
+static size_t get_length(const uint8_t *src, size_t *ip) {
+    size_t len = 0;
+    uint8_t b;
+
+    do {
+        b = src[(*ip)++];
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+/* Decompresses the LEN bytes at SRC, produced by lz_compress(),
+ * into the CAP bytes at DST. */
+static void lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    size_t ip = 0, op = 0;
+
+    while (ip < len) {
+        uint8_t token = src[ip++];
+        size_t lit_len = token >> 4, match_len, offset;
+
+        if (lit_len == 15)
+            lit_len += get_length(src, &ip);
+        ASSERT(op + lit_len <= cap);
+        memcpy(dst + op, src + ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip >= len)
+            break;
+
+        offset = src[ip] | src[ip + 1] << 8;
+        ip += 2;
+        match_len = token & 15;
+        if (match_len == 15)
+            match_len += get_length(src, &ip);
+        match_len += MIN_MATCH;
+        ASSERT(offset > 0 && offset <= op && op + match_len <= cap);
+        /* 겹치는 복사일 수 있으므로 한 바이트씩 복사한다. */
+        for (size_t i = 0; i < match_len; i++, op++) dst[op] = dst[op - offset];
+    }
+    ASSERT(op == cap);
+}